@@ -1,5 +1,10 @@
 ﻿// main.cpp - Multi-pass Shader Renderer with Full RAII and Cross-Pass iChannel Support
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -11,6 +16,31 @@
 #include <set>
 #include <filesystem>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <thread>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <afunix.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EVOLVE_HAVE_SSE2 1
+#endif
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
@@ -48,30 +78,37 @@ struct Texture {
 
     ~Texture() { destroy(); }
 
-    bool loadFromFile(const std::string& path) {
+    // Upload 8-bit pixels (rows bottom-up, 3 or 4 channels) with a full mip chain
+    void loadFromPixels(const unsigned char* data, int w, int h, int nChannels) {
         destroy();
-        stbi_set_flip_vertically_on_load(true);
-        int nChannels;
-        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nChannels, 0);
-        if (!data) {
-            std::cerr << "Failed to load texture: " << path << std::endl;
-            createEmpty();
-            return false;
-        }
-
+        width = w;
+        height = h;
         glGenTextures(1, &id);
         glBindTexture(GL_TEXTURE_2D, id);
 
         GLenum format = (nChannels == 3) ? GL_RGB : GL_RGBA;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
 
-        stbi_image_free(data);
-        return true;
+    // Estimated GPU footprint including the mip chain. Drivers pad RGB8 to 4 bytes per texel.
+    size_t gpuBytes() const {
+        if (!id) return 0;
+        size_t total = 0;
+        int w = width, h = height;
+        while (true) {
+            total += static_cast<size_t>(w) * h * 4;
+            if (w == 1 && h == 1) break;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+        return total;
     }
 
     void createEmpty() {
@@ -141,37 +178,69 @@ public:
     void destroy() { if (id) { glDeleteVertexArrays(1, &id); id = 0; } }
 };
 
+// Bytes per texel of the color formats a pass buffer may use
+inline size_t BytesPerTexel(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_RGBA16F: return 8;
+    case GL_RGBA8: return 4;
+    default: return 16;  // GL_RGBA32F
+    }
+}
+
+inline const char* FormatName(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_RGBA16F: return "RGBA16F";
+    case GL_RGBA8: return "RGBA8";
+    default: return "RGBA32F";
+    }
+}
+
 class Framebuffer {
 public:
     GLuint fbo = 0;
-    Texture colorTex;
+    Texture colorTex;      // colorTex.width/height = logical size seen by shaders
+    int width = 0;         // allocated storage size (may be larger when bucketed)
+    int height = 0;
+    GLenum format = GL_RGBA32F;
     Framebuffer() = default;
     Framebuffer(const Framebuffer&) = delete;
     Framebuffer& operator=(const Framebuffer&) = delete;
-    Framebuffer(Framebuffer&& other) noexcept : fbo(other.fbo), colorTex(std::move(other.colorTex)) { other.fbo = 0; }
+    Framebuffer(Framebuffer&& other) noexcept
+        : fbo(other.fbo), colorTex(std::move(other.colorTex)),
+          width(other.width), height(other.height), format(other.format) {
+        other.fbo = 0;
+    }
     Framebuffer& operator=(Framebuffer&& other) noexcept {
-        if (this != &other) { destroy(); fbo = other.fbo; colorTex = std::move(other.colorTex); other.fbo = 0; }
+        if (this != &other) {
+            destroy();
+            fbo = other.fbo; colorTex = std::move(other.colorTex);
+            width = other.width; height = other.height; format = other.format;
+            other.fbo = 0;
+        }
         return *this;
     }
     ~Framebuffer() { destroy(); }
 
-    // Create FBO with high-precision floating-point texture for accurate feedback
-    bool create(int w, int h) {
+    // Create FBO with a floating-point texture for accurate feedback.
+    // RGBA32F is the default; cheaper formats are opt-in per pass (see --pass-formats)
+    bool create(int w, int h, GLenum internalFormat = GL_RGBA32F) {
         destroy();
+        colorTex.destroy();
         glGenFramebuffers(1, &fbo);
         glBindFramebuffer(GL_FRAMEBUFFER, fbo);
         glGenTextures(1, &colorTex.id);
         glBindTexture(GL_TEXTURE_2D, colorTex.id);
 
-        // Use RGBA32F for full precision (required by texelFetch in Shadertoy-style code)
-        // And use NEAREST filtering because we are sampling via texelFetch, not texture()
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, w, h, 0, GL_RGBA, GL_FLOAT, nullptr);
+        // NEAREST filtering: buffers hold simulation state read back texel for texel,
+        // whatever the pass's format
+        format = internalFormat;
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, w, h, 0, GL_RGBA, GL_FLOAT, nullptr);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        colorTex.width = w;
-        colorTex.height = h;
+        colorTex.width = width = w;
+        colorTex.height = height = h;
 
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTex.id, 0);
         bool complete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
@@ -182,6 +251,77 @@ public:
     void bind() const { if (fbo) glBindFramebuffer(GL_FRAMEBUFFER, fbo); }
     static void unbind() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
     void destroy() { if (fbo) { glDeleteFramebuffers(1, &fbo); fbo = 0; } }
+
+    size_t bytes() const { return fbo ? static_cast<size_t>(width) * height * BytesPerTexel(format) : 0; }
+};
+
+// Pool of render targets keyed by allocated size and format.
+// Resizes release their old targets here and acquire new ones, so dragging a window
+// edge back and forth reuses storage instead of hitting the driver for every event.
+// With roundToBucket the storage is rounded up to kBucketGranularity; the logical
+// size (colorTex.width/height) still matches the request.
+class RenderTargetPool {
+public:
+    static constexpr int kBucketGranularity = 256;
+    bool roundToBucket = false;
+    size_t maxFreeBytes = 256u * 1024u * 1024u;
+
+    RenderTargetPool() = default;
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    Framebuffer acquire(int w, int h, GLenum format = GL_RGBA32F) {
+        int bw = bucketSize(w), bh = bucketSize(h);
+        for (auto it = free_.begin(); it != free_.end(); ++it) {
+            if (it->width == bw && it->height == bh && it->format == format) {
+                Framebuffer fb = std::move(*it);
+                freeBytes_ -= fb.bytes();
+                free_.erase(it);
+                ++reused;
+                setLogicalSize(fb, w, h);
+                return fb;
+            }
+        }
+        Framebuffer fb;
+        if (!fb.create(bw, bh, format)) {
+            std::cerr << "Failed to create " << bw << "x" << bh << " " << FormatName(format) << " render target\n";
+            fb.destroy();
+        }
+        ++allocated;
+        setLogicalSize(fb, w, h);
+        return fb;
+    }
+
+    void release(Framebuffer&& fb) {
+        if (!fb.fbo) return;
+        freeBytes_ += fb.bytes();
+        free_.push_back(std::move(fb));
+        // Oldest released targets go first; they are the least likely to come back
+        while (freeBytes_ > maxFreeBytes && !free_.empty()) {
+            freeBytes_ -= free_.front().bytes();
+            free_.erase(free_.begin());
+        }
+    }
+
+    void clear() { free_.clear(); freeBytes_ = 0; }
+    size_t freeBytes() const { return freeBytes_; }
+
+    int allocated = 0;
+    int reused = 0;
+
+private:
+    int bucketSize(int n) const {
+        n = std::max(n, 1);
+        if (!roundToBucket) return n;
+        return (n + kBucketGranularity - 1) / kBucketGranularity * kBucketGranularity;
+    }
+    static void setLogicalSize(Framebuffer& fb, int w, int h) {
+        fb.colorTex.width = w;
+        fb.colorTex.height = h;
+    }
+
+    std::vector<Framebuffer> free_;
+    size_t freeBytes_ = 0;
 };
 
 static GLuint CompileShader(GLenum type, const char* src);
@@ -249,8 +389,213 @@ static GLuint CreateProgram(const char* vertSrc, const char* fragSrc) {
     return prog;
 }
 
+// A tunable uniform declared in a .frag file with an annotation comment:
+//   // @param float uSpeed = 1.0 [0, 5]
+//   // @param vec3 uTint = 1 0.5 0.2 [0, 1]
+//   // @param bool uGlow = true
+// The uniform itself is declared by the prelude; the shader just uses it.
+struct CustomUniform {
+    enum Type { FLOAT, VEC2, VEC3, VEC4, INT, BOOL } type = FLOAT;
+    std::string name;
+    float minValue = -std::numeric_limits<float>::infinity();
+    float maxValue = std::numeric_limits<float>::infinity();
+    std::array<float, 4> value{};
+    GLint location = -1;
+    bool dirty = true;  // needs glUniform before the next draw
+
+    int components() const { return type == VEC2 ? 2 : type == VEC3 ? 3 : type == VEC4 ? 4 : 1; }
+
+    static const char* typeName(Type t) {
+        static const char* names[] = { "float", "vec2", "vec3", "vec4", "int", "bool" };
+        return names[t];
+    }
+
+    // Clamp and round to the declared type; returns true if the stored value changed
+    bool set(const float* v, int n) {
+        bool changed = false;
+        for (int c = 0; c < components() && c < n; ++c) {
+            float x = std::clamp(v[c], minValue, maxValue);
+            if (type == INT) x = std::round(x);
+            if (type == BOOL) x = x != 0.0f ? 1.0f : 0.0f;
+            if (x != value[c]) { value[c] = x; changed = true; }
+        }
+        dirty |= changed;
+        return changed;
+    }
+
+    void upload() {
+        if (location != -1) {
+            switch (type) {
+            case FLOAT: glUniform1f(location, value[0]); break;
+            case VEC2: glUniform2f(location, value[0], value[1]); break;
+            case VEC3: glUniform3f(location, value[0], value[1], value[2]); break;
+            case VEC4: glUniform4f(location, value[0], value[1], value[2], value[3]); break;
+            case INT:
+            case BOOL: glUniform1i(location, static_cast<int>(value[0])); break;
+            }
+        }
+        dirty = false;
+    }
+};
+
+// Parse "1 2 3" or "1, 2, 3" (and true/false) into up to 4 floats; returns the count
+int ParseFloatList(const std::string& text, float out[4]) {
+    std::string t = text;
+    std::replace(t.begin(), t.end(), ',', ' ');
+    std::stringstream ss(t);
+    std::string tok;
+    int n = 0;
+    while (n < 4 && ss >> tok) {
+        if (tok == "true") out[n++] = 1.0f;
+        else if (tok == "false") out[n++] = 0.0f;
+        else {
+            try { out[n++] = std::stof(tok); }
+            catch (...) { break; }
+        }
+    }
+    return n;
+}
+
+// Collect '// @param' annotations from shader source
+std::vector<CustomUniform> ParseCustomUniforms(const std::string& code) {
+    static const std::regex pattern(
+        R"(^\s*//\s*@param\s+(float|vec2|vec3|vec4|int|bool)\s+([A-Za-z_]\w*)\s*(?:=\s*([^\[]*?))?\s*(?:\[\s*([^,\]]+)\s*,\s*([^\]]+)\])?\s*$)");
+    static const std::map<std::string, CustomUniform::Type> types = {
+        { "float", CustomUniform::FLOAT }, { "vec2", CustomUniform::VEC2 }, { "vec3", CustomUniform::VEC3 },
+        { "vec4", CustomUniform::VEC4 }, { "int", CustomUniform::INT }, { "bool", CustomUniform::BOOL } };
+
+    std::vector<CustomUniform> result;
+    std::stringstream ss(code);
+    std::string line;
+    while (std::getline(ss, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::smatch m;
+        if (!std::regex_match(line, m, pattern)) continue;
+        CustomUniform u;
+        u.type = types.at(m[1]);
+        u.name = m[2];
+        float bound[4];
+        if (m[4].matched && ParseFloatList(m[4], bound) == 1) u.minValue = bound[0];
+        if (m[5].matched && ParseFloatList(m[5], bound) == 1) u.maxValue = bound[0];
+        if (u.type == CustomUniform::BOOL) { u.minValue = 0.0f; u.maxValue = 1.0f; }
+        if (u.minValue > u.maxValue) {  // std::clamp requires min <= max
+            std::cerr << "@param " << u.name << ": range [" << u.minValue << ", " << u.maxValue << "] is inverted, using ["
+                      << u.maxValue << ", " << u.minValue << "]\n";
+            std::swap(u.minValue, u.maxValue);
+        }
+        float def[4] = { 0, 0, 0, 0 };
+        int n = m[3].matched ? ParseFloatList(m[3], def) : 0;
+        for (int c = n; c < 4; ++c) def[c] = n > 0 ? def[n - 1] : 0.0f;  // "vec3 = 1" means (1,1,1)
+        u.value = { 0, 0, 0, 0 };
+        u.set(def, 4);
+        result.push_back(u);
+    }
+    return result;
+}
+
+// GLSL declarations for the custom uniforms, inserted into the prelude
+std::string CustomUniformDeclarations(const std::vector<CustomUniform>& params) {
+    std::string decls;
+    for (const auto& u : params) {
+        const char* glslType = u.type == CustomUniform::BOOL ? "bool" : CustomUniform::typeName(u.type);
+        decls += std::string("uniform ") + glslType + " " + u.name + ";\n";
+    }
+    return decls;
+}
+
+// Quality tiers are declared per pass with one value per tier, lowest quality first:
+//   // @quality STEPS 32 64 128
+//   // @quality SAMPLES 1 2 4
+// Each tier is compiled as its own program with those #defines (plus QUALITY_TIER).
+// The shader's own '#define STEPS ...' line, if any, is dropped so it can keep a default.
+struct QualityDefine {
+    std::string name;
+    std::vector<std::string> values;
+};
+
+std::vector<QualityDefine> ParseQualityDefines(const std::string& code) {
+    static const std::regex pattern(R"(^\s*//\s*@quality\s+([A-Za-z_]\w*)\s+(.+?)\s*$)");
+    std::vector<QualityDefine> result;
+    std::stringstream ss(code);
+    std::string line;
+    while (std::getline(ss, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::smatch m;
+        if (!std::regex_match(line, m, pattern)) continue;
+        QualityDefine d;
+        d.name = m[1];
+        std::stringstream values(m[2].str());
+        std::string v;
+        while (values >> v) d.values.push_back(v);
+        result.push_back(d);
+    }
+    return result;
+}
+
+int QualityTierCount(const std::vector<QualityDefine>& defines) {
+    size_t n = 1;
+    for (const auto& d : defines) n = std::max(n, d.values.size());
+    return static_cast<int>(n);
+}
+
+// Source and #define block for one tier. Blanking (not removing) the shader's own
+// defines keeps compiler error line numbers meaningful.
+std::string ApplyQualityTier(const std::string& code, const std::vector<QualityDefine>& defines,
+    int tier, std::string& defineBlock) {
+    defineBlock = "#define QUALITY_TIER " + std::to_string(tier) + "\n";
+    if (defines.empty()) return code;
+    for (const auto& d : defines) {
+        // Fewer values than tiers: the last value covers the higher tiers
+        const std::string& v = d.values[std::min(static_cast<size_t>(tier), d.values.size() - 1)];
+        defineBlock += "#define " + d.name + " " + v + "\n";
+    }
+    std::stringstream in(code);
+    std::string out, line;
+    static const std::regex definePattern(R"(^\s*#\s*define\s+([A-Za-z_]\w*)\b.*$)");
+    while (std::getline(in, line)) {
+        std::smatch m;
+        if (std::regex_match(line, m, definePattern)) {
+            std::string name = m[1];
+            bool overridden = std::any_of(defines.begin(), defines.end(),
+                [&](const QualityDefine& d) { return d.name == name; });
+            if (overridden) line.clear();
+        }
+        out += line + "\n";
+    }
+    return out;
+}
+
+// Bucketed buffers are larger than the size the shaders see, so normalized coordinates
+// into them must be scaled. Rewrites the coordinate argument of texture(iChannelN, uv, ...)
+// (and the Lod/Offset/Grad variants) to (uv) * iChannelUVScale[N]; texelFetch already
+// addresses texels and is left alone.
+std::string ScaleChannelSampling(const std::string& code) {
+    static const std::regex call(R"(\b(texture|textureLod|textureOffset|textureLodOffset|textureGrad)\s*\(\s*iChannel([0-3])\s*,)");
+    std::string out;
+    size_t pos = 0;
+    std::smatch m;
+    auto begin = code.cbegin();
+    while (std::regex_search(begin + pos, code.cend(), m, call)) {
+        size_t argStart = pos + m.position(0) + m.length(0);
+        // The coordinate argument ends at the first top-level ',' or ')'
+        size_t end = argStart;
+        int depth = 0;
+        for (; end < code.size(); ++end) {
+            char c = code[end];
+            if (c == '(' || c == '[') ++depth;
+            else if ((c == ')' || c == ']') && depth > 0) --depth;
+            else if ((c == ',' || c == ')') && depth == 0) break;
+        }
+        out.append(code, pos, argStart - pos);
+        out += "(" + ScaleChannelSampling(code.substr(argStart, end - argStart)) + ") * iChannelUVScale[" + m[2].str() + "]";
+        pos = end;
+    }
+    out.append(code, pos, std::string::npos);
+    return out;
+}
+
 // Wrap a Shadertoy-like fragment shader with standard OpenGL boilerplate
-std::string WrapShadertoyShader(const std::string& code) {
+std::string WrapShadertoyShader(const std::string& code, const std::string& extraDecls = "") {
     std::string prelude = R"GLSL(
 #version 330 core
 out vec4 fragColor;
@@ -265,14 +610,16 @@ uniform sampler2D iChannel1;
 uniform sampler2D iChannel2;
 uniform sampler2D iChannel3;
 uniform vec3 iChannelResolution[4];
+uniform vec2 iChannelUVScale[4];  // logical / allocated size of bucketed buffers, 1 otherwise
+uniform vec4 iTileRect;  // poster export: xy = tile origin, zw = tile size on the canvas; 0 = whole canvas
 )GLSL";
     std::string postlude = R"GLSL(
 void main() {
-    vec2 fragCoord = vTex * iResolution.xy;
+    vec2 fragCoord = iTileRect.z > 0.0 ? iTileRect.xy + vTex * iTileRect.zw : vTex * iResolution.xy;
     mainImage(fragColor, fragCoord);
 }
 )GLSL";
-    return prelude + code + postlude;
+    return prelude + extraDecls + code + postlude;
 }
 
 // Load shader source from file
@@ -287,26 +634,226 @@ std::string LoadShaderFile(const std::string& path) {
     return ss.str();
 }
 
-// Global texture cache to avoid reloading same image multiple times
-std::map<std::string, Texture> g_globalTextureCache;
+// Decoded images are also kept on disk as raw, already-flipped pixels, so reloading an
+// evicted texture skips PNG/JPEG decoding. Entries are invalidated by source size and mtime.
+// Reading an entry refreshes its file time, and the directory is pruned oldest first
+// whenever a new entry pushes it over its budget.
+const char* kTextureDiskCacheDir = ".texcache";
+
+struct RawImageHeader {
+    char magic[4] = { 'E', 'V', 'T', 'X' };
+    uint32_t version = 1;
+    int32_t width = 0, height = 0, channels = 0;
+    uint32_t reserved = 0;  // explicit padding, so no uninitialised bytes reach the file
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+};
+static_assert(sizeof(RawImageHeader) == 40, "RawImageHeader must have no implicit padding");
+
+static fs::path RawImagePath(const std::string& path) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.raw", (unsigned long long)std::hash<std::string>{}(path));
+    return fs::path(kTextureDiskCacheDir) / name;
+}
+
+static bool SourceStamp(const std::string& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) return false;
+    auto t = fs::last_write_time(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(t.time_since_epoch().count());
+    return true;
+}
+
+static bool LoadRawImage(const std::string& path, std::vector<unsigned char>& pixels, RawImageHeader& header) {
+    uint64_t size; int64_t mtime;
+    if (!SourceStamp(path, size, mtime)) return false;
+    std::ifstream in(RawImagePath(path), std::ios::binary);
+    if (!in) return false;
+    RawImageHeader expected;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, expected.magic, 4) != 0 || header.version != expected.version ||
+        header.sourceSize != size || header.sourceMtime != mtime ||
+        header.width <= 0 || header.height <= 0 || (header.channels != 3 && header.channels != 4)) return false;
+    pixels.resize(static_cast<size_t>(header.width) * header.height * header.channels);
+    if (!in.read(reinterpret_cast<char*>(pixels.data()), pixels.size())) return false;
+    std::error_code ec;
+    fs::last_write_time(RawImagePath(path), fs::file_time_type::clock::now(), ec);
+    return true;
+}
 
-// Get or load a texture from disk
-Texture* GetTextureForPath(const std::string& path) {
-    auto it = g_globalTextureCache.find(path);
-    if (it != g_globalTextureCache.end()) return &it->second;
-    Texture tex;
-    if (tex.loadFromFile(path)) {
-        auto result = g_globalTextureCache.emplace(path, std::move(tex));
-        return &result.first->second;
+// Deletes the least recently used raw images until the directory fits budgetBytes
+static void PruneRawImages(size_t budgetBytes) {
+    struct CacheFile { fs::path path; fs::file_time_type time; uintmax_t size; };
+    std::vector<CacheFile> files;
+    uintmax_t total = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(kTextureDiskCacheDir, ec)) {
+        if (!entry.is_regular_file(ec) || entry.path().extension() != ".raw") continue;
+        CacheFile f{ entry.path(), entry.last_write_time(ec), entry.file_size(ec) };
+        if (ec) continue;
+        total += f.size;
+        files.push_back(std::move(f));
     }
-    else {
-        static Texture empty;
-        static bool init = false;
-        if (!init) { empty.createEmpty(); init = true; }
-        return &empty;
+    if (total <= budgetBytes) return;
+    std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.time < b.time; });
+    for (const auto& f : files) {
+        if (total <= budgetBytes) break;
+        if (fs::remove(f.path, ec)) total -= f.size;
     }
 }
 
+static void StoreRawImage(const std::string& path, const unsigned char* data, int w, int h, int channels,
+    size_t budgetBytes) {
+    size_t bytes = sizeof(RawImageHeader) + static_cast<size_t>(w) * h * channels;
+    if (bytes > budgetBytes) return;
+    RawImageHeader header;
+    if (!SourceStamp(path, header.sourceSize, header.sourceMtime)) return;
+    header.width = w; header.height = h; header.channels = channels;
+    std::error_code ec;
+    fs::create_directories(kTextureDiskCacheDir, ec);
+    {
+        std::ofstream out(RawImagePath(path), std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(w) * h * channels);
+    }
+    PruneRawImages(budgetBytes);
+}
+
+// GPU texture cache with a memory budget. Textures are loaded on first bind and
+// evicted least-recently-bound first once the budget is exceeded. Textures bound
+// during the current frame are never evicted, so pointers stay valid until the draw.
+class TextureCache {
+public:
+    size_t budgetBytes = 512u * 1024u * 1024u;
+    size_t diskBudgetBytes = size_t(2048) * 1024u * 1024u;  // raw copies in kTextureDiskCacheDir; 0 = off
+
+    size_t hits = 0, misses = 0, evictions = 0;
+
+    TextureCache() = default;
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    void beginFrame() { ++frame_; }
+
+    // Get or load a texture from disk
+    Texture* get(const std::string& path) {
+        auto it = entries_.find(path);
+        if (it != entries_.end()) {
+            ++hits;
+            Entry& e = it->second;
+            lru_.splice(lru_.end(), lru_, e.lruPos);
+            e.lastFrame = frame_;
+            return &e.tex;
+        }
+        if (failed_.count(path)) return emptyTexture();
+
+        ++misses;
+        Entry e;
+        if (!load(path, e.tex)) {
+            failed_.insert(path);
+            return emptyTexture();
+        }
+        e.bytes = e.tex.gpuBytes();
+        e.lastFrame = frame_;
+        e.lruPos = lru_.insert(lru_.end(), path);
+        bytes_ += e.bytes;
+        auto result = entries_.emplace(path, std::move(e));
+        evictOverBudget();
+        return &result.first->second.tex;
+    }
+
+    // Load ahead of the first frame without pinning the texture for this frame
+    void prefetch(const std::string& path) {
+        if (entries_.count(path) || failed_.count(path)) return;
+        get(path);
+        auto it = entries_.find(path);
+        if (it != entries_.end()) it->second.lastFrame = frame_ - 1;
+    }
+
+    void clear() {
+        entries_.clear();
+        lru_.clear();
+        failed_.clear();
+        empty_.destroy();
+        bytes_ = 0;
+    }
+
+    size_t size() const { return entries_.size(); }
+    size_t bytes() const { return bytes_; }
+
+    std::string statsString() const {
+        char buf[160];
+        snprintf(buf, sizeof(buf), "%zu textures, %.1f / %.0f MB, hits %zu, misses %zu, evictions %zu",
+            entries_.size(), bytes_ / 1048576.0, budgetBytes / 1048576.0, hits, misses, evictions);
+        return buf;
+    }
+
+private:
+    struct Entry {
+        Texture tex;
+        size_t bytes = 0;
+        unsigned long long lastFrame = 0;
+        std::list<std::string>::iterator lruPos;
+    };
+
+    bool load(const std::string& path, Texture& tex) const {
+        std::vector<unsigned char> raw;
+        RawImageHeader header;
+        if (diskBudgetBytes > 0 && LoadRawImage(path, raw, header)) {
+            tex.loadFromPixels(raw.data(), header.width, header.height, header.channels);
+            return true;
+        }
+        stbi_set_flip_vertically_on_load(true);
+        int w, h, nChannels;
+        unsigned char* data = stbi_load(path.c_str(), &w, &h, &nChannels, 0);
+        if (!data) {
+            std::cerr << "Failed to load texture: " << path << std::endl;
+            return false;
+        }
+        // Grey and grey+alpha images are expanded to RGBA so the raw copy stays 3 or 4 channels
+        if (nChannels < 3) {
+            stbi_image_free(data);
+            data = stbi_load(path.c_str(), &w, &h, &nChannels, 4);
+            if (!data) return false;
+            nChannels = 4;
+        }
+        tex.loadFromPixels(data, w, h, nChannels);
+        if (diskBudgetBytes > 0) StoreRawImage(path, data, w, h, nChannels, diskBudgetBytes);
+        stbi_image_free(data);
+        return true;
+    }
+
+    void evictOverBudget() {
+        auto it = lru_.begin();
+        while (bytes_ > budgetBytes && it != lru_.end()) {
+            auto entry = entries_.find(*it);
+            if (entry->second.lastFrame == frame_) { ++it; continue; }
+            bytes_ -= entry->second.bytes;
+            entries_.erase(entry);
+            it = lru_.erase(it);
+            ++evictions;
+        }
+    }
+
+    Texture* emptyTexture() {
+        if (!empty_.id) empty_.createEmpty();
+        return &empty_;
+    }
+
+    std::unordered_map<std::string, Entry> entries_;
+    std::list<std::string> lru_;               // front = least recently bound
+    std::unordered_set<std::string> failed_;   // don't retry (and re-log) broken files every frame
+    Texture empty_;
+    size_t bytes_ = 0;
+    unsigned long long frame_ = 1;
+};
+
+// Global texture cache to avoid reloading same image multiple times
+TextureCache g_textureCache;
+
 // Scan 'iChannel' folder for global images
 std::vector<fs::path> ScanGlobalImages() {
     std::vector<fs::path> images;
@@ -334,110 +881,1928 @@ struct ChannelInput {
     int imageIndex = -1;   // index in global image list
 };
 
-// Mouse state
+// Lock-free single-producer/single-consumer ring buffer. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+    // Producer side; returns false when the queue is full
+    bool push(const T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == Capacity) return false;
+        buffer_[head & (Capacity - 1)] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; returns false when the queue is empty
+    bool pop(T& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        out = buffer_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    std::array<T, Capacity> buffer_{};
+};
+
+// Complete input state at one instant, produced by the event thread for the render thread.
+// Snapshots are self-contained, so the render thread only needs the newest one.
+struct InputSnapshot {
+    enum Source { MOUSE, RESIZE } source = MOUSE;
+    double time = 0.0;              // glfwGetTime() when the event arrived
+    double mouseX = 0.0, mouseY = 0.0;
+    int mouseDown = 0;
+    int fbWidth = 0, fbHeight = 0;  // latest framebuffer size reported by GLFW
+};
+
+SpscQueue<InputSnapshot, 256> g_inputQueue;
+
+// Mouse state (event thread only)
 double g_mouseX = 0.0, g_mouseY = 0.0;
 int g_mouseDown = 0;
 
-// Window size
+// Window size (render thread only)
 int g_winWidth = 1280, g_winHeight = 720;
 
-// Start time for iTime
-std::chrono::steady_clock::time_point g_start;
+// Latest framebuffer size reported by GLFW (event thread only); the render thread
+// applies it at a frame boundary once no new resize has arrived for the debounce interval
+int g_pendingWidth = 1280, g_pendingHeight = 720;
 
-// Global frame counter (shared across all passes)
-int g_frame = 0;
+// Set if a snapshot could not be queued; the event loop retries it unchanged (same source
+// and timestamp) so the final state always arrives and latency stats stay honest
+bool g_inputPushFailed = false;
+InputSnapshot g_droppedSnapshot;
 
-// GLFW cursor callback
-void cursorPosCallback(GLFWwindow* window, double x, double y) {
-    g_mouseX = x;
-    g_mouseY = y;
-}
+// Render thread -> event thread: window title with FPS stats (glfwSetWindowTitle is main-thread only)
+std::mutex g_titleMutex;
+std::string g_pendingTitle;
 
-// GLFW mouse button callback
-void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
-    g_mouseDown = (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) ? 1 : 0;
-}
+// Event thread -> render thread: stop rendering and release the context
+std::atomic<bool> g_quit{ false };
 
-// Handle window resize
-void framebufferSizeCallback(GLFWwindow* window, int w, int h) {
-    g_winWidth = w;
-    g_winHeight = h;
-    glViewport(0, 0, w, h);
-    auto* pFbos = static_cast<std::vector<Framebuffer>*>(glfwGetWindowUserPointer(window));
-    if (pFbos) for (auto& fbo : *pFbos) fbo.create(w, h);
-}
+// Control socket -> render thread: new value for one custom uniform
+struct ParamUpdate {
+    int pass = 0;
+    int index = 0;   // into Pipeline::params[pass]
+    int count = 0;
+    float value[4] = {};
+};
 
-// Simple fullscreen quad vertex shader
-const char* vertShaderSrc = R"GLSL(
-#version 330 core
-layout(location=0) in vec2 aPos;
-layout(location=1) in vec2 aTex;
-out vec2 vTex;
-void main() {
-    vTex = aTex;
-    gl_Position = vec4(aPos, 0.0, 1.0);
+SpscQueue<ParamUpdate, 4096> g_paramQueue;
+
+// Control socket -> render thread: output path of a requested poster export (empty = none)
+std::mutex g_exportMutex;
+std::string g_exportRequest;
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+const socket_t kInvalidSocket = INVALID_SOCKET;
+inline void CloseSocket(socket_t s) { closesocket(s); }
+#else
+using socket_t = int;
+const socket_t kInvalidSocket = -1;
+inline void CloseSocket(socket_t s) { close(s); }
+#endif
+
+// Exports requested over the control socket may only name a new image in the working
+// directory: a bare file name with an image extension, no directories and no '..', so a
+// client cannot overwrite arbitrary files of the user. Whether the file already exists is
+// checked separately, both when the request arrives and again before writing.
+bool IsSafeExportName(const std::string& name) {
+    if (name.empty() || name[0] == '.' || name.find_first_of("/\\:") != std::string::npos) return false;
+    std::string ext = fs::path(name).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".png" || ext == ".tif" || ext == ".tiff";
 }
-)GLSL";
 
-// Scan 'frag' directory for .frag files, sorted by number prefix
-std::vector<std::string> ScanShaderFiles() {
-    std::vector<std::pair<int, fs::path>> entries;
-    for (const auto& entry : fs::directory_iterator("frag")) {
-        if (entry.is_regular_file() && entry.path().extension() == ".frag") {
-            std::string stem = entry.path().stem().string();
-            std::regex numPattern(R"((\d+))");
-            std::smatch match;
-            if (std::regex_search(stem, match, numPattern)) {
-                entries.emplace_back(std::stoi(match[1]), entry.path());
-            }
+// Local control interface for custom uniforms: a Unix domain socket with a line protocol.
+//   set <name> <values...>         every pass that declares <name>
+//   set <pass>.<name> <values...>  one pass, by buffer index
+//   list                           one line per parameter: "<pass>.<name> <type> <min> <max> <value...>"
+//   ping                           replies "pong"
+//   export [name]                  tiled poster export with the --export-* settings into the working
+//                                  directory; name is a bare .png/.tif/.tiff file name that must not
+//                                  exist yet (default poster.png)
+// 'set' sends no reply unless it fails, so tools can stream hundreds of updates per second.
+// Updates reach the render thread through g_paramQueue and are applied at frame start.
+class ControlServer {
+public:
+    struct ParamInfo {
+        int pass;
+        int index;
+        CustomUniform decl;
+    };
+
+    ControlServer(std::string path, std::vector<ParamInfo> catalog)
+        : path_(std::move(path)), catalog_(std::move(catalog)) {}
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+    ~ControlServer() { stop(); }
+
+    bool start() {
+#ifdef _WIN32
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+        wsaStarted_ = true;
+#endif
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path_.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Control socket path too long: " << path_ << "\n";
+            return false;
         }
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+        std::error_code ec;
+        fs::remove(path_, ec);  // stale socket from a previous run
+
+        listen_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_ == kInvalidSocket ||
+            bind(listen_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listen_, 4) != 0) {
+            std::cerr << "Failed to open control socket: " << path_ << "\n";
+            if (listen_ != kInvalidSocket) CloseSocket(listen_);
+            listen_ = kInvalidSocket;
+            return false;
+        }
+        std::cout << "Control socket listening on " << path_ << " (" << catalog_.size() << " parameter(s))\n";
+        thread_ = std::thread([this] { run(); });
+        return true;
     }
-    std::sort(entries.begin(), entries.end());
-    std::vector<std::string> result;
-    for (auto& [idx, path] : entries) result.push_back(path.string());
-    return result;
-}
 
-// Interactive setup for iChannel connections
-std::vector<std::array<ChannelInput, 4>> ConfigureChannelsInteractively(
-    const std::vector<std::string>& files,
-    const std::vector<fs::path>& globalImages) {
+    void stop() {
+        stop_.store(true, std::memory_order_release);
+        if (thread_.joinable()) thread_.join();
+        if (listen_ != kInvalidSocket) {
+            CloseSocket(listen_);
+            listen_ = kInvalidSocket;
+            std::error_code ec;
+            fs::remove(path_, ec);
+        }
+#ifdef _WIN32
+        if (wsaStarted_) { WSACleanup(); wsaStarted_ = false; }
+#endif
+    }
 
-    int N = static_cast<int>(files.size());
-    std::vector<std::array<ChannelInput, 4>> configs(N);
-    for (auto& chs : configs) for (int i = 0; i < 4; ++i) chs[i].type = ChannelInput::NONE;
+private:
+    struct Client {
+        socket_t socket;
+        std::string buffer;
+    };
 
-    std::cout << "\n=== Interactive iChannel Setup ===\n";
-    std::cout << " Press Enter for auto-chain (buffer0 → buffer1 → ...),\n";
-    std::cout << " or type a buffer index to configure manually: ";
+    void run() {
+        std::vector<Client> clients;
+        char chunk[4096];
+        while (!stop_.load(std::memory_order_acquire)) {
+            flushPending();
+
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listen_, &readable);
+            socket_t maxSocket = listen_;
+            for (const auto& c : clients) {
+                FD_SET(c.socket, &readable);
+                maxSocket = std::max(maxSocket, c.socket);
+            }
+            // Poll quickly while updates are waiting for queue space
+            timeval timeout{ 0, pending_.empty() ? 100000 : 1000 };
+            if (select(static_cast<int>(maxSocket) + 1, &readable, nullptr, nullptr, &timeout) <= 0) continue;
 
-    std::string line;
-    std::getline(std::cin, line);
+            if (FD_ISSET(listen_, &readable)) {
+                socket_t c = accept(listen_, nullptr, nullptr);
+                if (c != kInvalidSocket) clients.push_back({ c, std::string() });
+            }
+            for (size_t i = 0; i < clients.size();) {
+                Client& c = clients[i];
+                if (FD_ISSET(c.socket, &readable)) {
+                    int n = static_cast<int>(recv(c.socket, chunk, sizeof(chunk), 0));
+                    if (n <= 0) {
+                        CloseSocket(c.socket);
+                        clients.erase(clients.begin() + i);
+                        continue;
+                    }
+                    c.buffer.append(chunk, n);
+                    size_t start = 0, eol;
+                    while ((eol = c.buffer.find('\n', start)) != std::string::npos) {
+                        handleLine(c.socket, c.buffer.substr(start, eol - start));
+                        start = eol + 1;
+                    }
+                    c.buffer.erase(0, start);
+                    if (c.buffer.size() > 4096) c.buffer.clear();  // runaway line without newline
+                }
+                ++i;
+            }
+        }
+        for (auto& c : clients) CloseSocket(c.socket);
+    }
 
-    if (line.empty()) {
-        std::cout << " Auto-chain: ";
-        for (int i = 1; i < N; ++i) {
-            configs[i][0].type = ChannelInput::BUFFER;
-            configs[i][0].bufferIndex = i - 1;
-            std::cout << "buffer" << i - 1 << " → ";
+    void reply(socket_t client, const std::string& text) {
+#ifdef MSG_NOSIGNAL
+        send(client, text.data(), static_cast<int>(text.size()), MSG_NOSIGNAL);
+#else
+        send(client, text.data(), static_cast<int>(text.size()), 0);
+#endif
+    }
+
+    void handleLine(socket_t client, std::string line) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::stringstream ss(line);
+        std::string command, target;
+        ss >> command;
+        if (command == "ping") {
+            reply(client, "pong\n");
+        }
+        else if (command == "list") {
+            std::string out;
+            for (const auto& info : catalog_) {
+                const CustomUniform& u = info.decl;
+                char buf[256];
+                snprintf(buf, sizeof(buf), "%d.%s %s %g %g", info.pass, u.name.c_str(),
+                    CustomUniform::typeName(u.type), u.minValue, u.maxValue);
+                out += buf;
+                for (int c = 0; c < u.components(); ++c) out += " " + std::to_string(u.value[c]);
+                out += "\n";
+            }
+            out += ".\n";
+            reply(client, out);
+        }
+        else if (command == "set" && (ss >> target)) {
+            std::string rest;
+            std::getline(ss, rest);
+            ParamUpdate update;
+            update.count = ParseFloatList(rest, update.value);
+            if (update.count == 0) { reply(client, "error missing value\n"); return; }
+
+            int pass = -1;
+            std::string name = target;
+            size_t dot = target.find('.');
+            if (dot != std::string::npos) {
+                try { pass = std::stoi(target.substr(0, dot)); }
+                catch (...) { reply(client, "error bad pass index\n"); return; }
+                name = target.substr(dot + 1);
+            }
+            bool matched = false;
+            for (auto& info : catalog_) {
+                if (info.decl.name != name || (pass >= 0 && info.pass != pass)) continue;
+                update.pass = info.pass;
+                update.index = info.index;
+                enqueue(update);
+                info.decl.set(update.value, update.count);  // same clamping as the render thread, for 'list'
+                matched = true;
+            }
+            if (!matched) reply(client, "error unknown parameter " + target + "\n");
+        }
+        else if (command == "export") {
+            std::string path = "poster.png";
+            ss >> path;
+            if (!IsSafeExportName(path)) {
+                reply(client, "error export takes a bare .png/.tif/.tiff file name\n");
+                return;
+            }
+            std::error_code ec;
+            if (fs::exists(path, ec) || ec) {
+                reply(client, "error " + path + " already exists\n");
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(g_exportMutex);
+                g_exportRequest = path;
+            }
+            reply(client, "queued " + path + "\n");
+        }
+        else if (!command.empty()) {
+            reply(client, "error unknown command " + command + "\n");
         }
-        if (N > 0) std::cout << "buffer" << N - 1 << "\n\n";
-        return configs;
     }
 
-    while (true) {
+    // Queue an update; if the render thread is behind, keep only the newest value per parameter
+    void enqueue(const ParamUpdate& update) {
+        if (pending_.empty() && g_paramQueue.push(update)) return;
+        for (auto& p : pending_) {
+            if (p.pass == update.pass && p.index == update.index) { p = update; return; }
+        }
+        pending_.push_back(update);
+    }
+
+    void flushPending() {
+        size_t sent = 0;
+        while (sent < pending_.size() && g_paramQueue.push(pending_[sent])) ++sent;
+        pending_.erase(pending_.begin(), pending_.begin() + sent);
+    }
+
+    std::string path_;
+    std::vector<ParamInfo> catalog_;
+    socket_t listen_ = kInvalidSocket;
+    std::thread thread_;
+    std::atomic<bool> stop_{ false };
+    std::vector<ParamUpdate> pending_;
+#ifdef _WIN32
+    bool wsaStarted_ = false;
+#endif
+};
+
+// How the render loop is paced against the display and the GPU
+enum class PacingMode {
+    UNCAPPED,     // swap interval 0, render as fast as possible
+    VSYNC,        // swap interval 1
+    FPS_CAP,      // swap interval 0, precise sleep to a fixed frame rate
+    LOW_LATENCY   // bounded frames in flight via fences, input sampled right before submit
+};
+
+// How feedback buffers carry their contents across a resize
+enum class FeedbackResample {
+    AUTO,     // KEEP for passes that address texels directly (texelFetch), STRETCH otherwise
+    STRETCH,  // bilinear rescale of the whole image
+    KEEP      // 1:1 copy anchored at the origin; preserves per-texel simulation state
+};
+
+// An extra pipeline for multi-view mode: '--view=<dir>[,<W>x<H>][,headless]'
+struct ViewSpec {
+    std::string dir;
+    int width = 0, height = 0;   // 0 = same as the main window
+    bool headless = false;       // render offscreen, no window
+};
+
+// Command-line options; defaults match the plain interactive workflow
+struct AppOptions {
+    double resizeDebounceSec = 0.12;
+    bool bucketedTargets = false;
+    FeedbackResample feedbackResample = FeedbackResample::AUTO;
+    PacingMode pacing = PacingMode::UNCAPPED;
+    double fpsCap = 0.0;          // FPS_CAP target; also caps LOW_LATENCY when set
+    int maxFramesInFlight = 1;    // LOW_LATENCY only
+    size_t textureBudgetMB = 512;
+    size_t textureDiskCacheMB = 2048;  // 0 disables the raw image cache on disk
+    std::vector<GLenum> passFormats;  // per-pass buffer format, missing entries are RGBA32F
+    int analyzeFrames = 0;            // > 0: run the buffer format advisor and exit
+    double formatMinPsnr = 48.0;      // advisor tolerance, dB on the final image
+    double formatMaxError = 4.0 / 255.0;
+    std::string controlSocket;        // non-empty: serve the parameter control socket here
+    std::string recordPath;           // write per-frame time/input to this file
+    std::string replayPath;           // feed time/input from this file instead of the clock and mouse
+    std::string replayTimingsPath;    // per-frame GPU times of a replay as CSV
+    bool headless = false;            // replay without showing the window or presenting frames
+    bool skipStaticPasses = false;    // don't re-render passes that look time-independent
+    int qualityTier = -1;             // >= 0 pins the quality tier; -1 = automatic
+    double gpuBudgetMs = 14.0;        // automatic tier selection target
+    std::string exportPath;           // render a poster to this file after exportFrame frames, then exit
+    int exportWidth = 0;              // poster size; 0 = 4x the window
+    int exportHeight = 0;
+    int exportSupersample = 2;        // N x N samples per poster pixel
+    int exportTile = 0;               // edge of one rendered (supersampled) tile; 0 = fit kExportTileBytes
+    int exportDpi = 300;              // print resolution stored in the file
+    int exportBitDepth = 8;           // 8 or 16 bits per channel
+    int exportFrame = 1;              // frames rendered before the poster is taken
+    std::vector<ViewSpec> views;      // non-empty: multi-view mode, the 'frag' pipeline is view 0
+};
+
+// Parse "32f", "16f", "8" (or the full GL names) into an internal format; 0 if unknown
+GLenum ParseFormatName(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    if (name == "32f" || name == "rgba32f") return GL_RGBA32F;
+    if (name == "16f" || name == "rgba16f") return GL_RGBA16F;
+    if (name == "8" || name == "rgba8") return GL_RGBA8;
+    return 0;
+}
+
+AppOptions ParseCommandLine(int argc, char** argv) {
+    AppOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) { value = arg.substr(eq + 1); arg = arg.substr(0, eq); }
         try {
-            int idx = std::stoi(line);
-            if (idx < 0 || idx >= N) {
-                std::cout << " Invalid index. Choose 0-" << N - 1 << ": ";
-                std::getline(std::cin, line);
-                continue;
+            if (arg == "--resize-debounce") {
+                opts.resizeDebounceSec = std::max(0, std::stoi(value)) / 1000.0;
             }
-            std::string fname = fs::path(files[idx]).filename().string();
-            std::cout << "\n Configuring buffer" << idx << " (" << fname << "):\n";
-            for (int c = 0; c < 4; ++c) {
-                std::cout << "\niChannel" << c << " source:\n";
-                std::cout << "  1: none\n";
+            else if (arg == "--bucket-fbos") {
+                opts.bucketedTargets = true;
+            }
+            else if (arg == "--pacing") {
+                if (value == "uncapped") opts.pacing = PacingMode::UNCAPPED;
+                else if (value == "vsync") opts.pacing = PacingMode::VSYNC;
+                else if (value == "cap") opts.pacing = PacingMode::FPS_CAP;
+                else if (value == "low-latency") opts.pacing = PacingMode::LOW_LATENCY;
+                else std::cerr << "Unknown --pacing mode: " << value << "\n";
+            }
+            else if (arg == "--fps-cap") {
+                opts.fpsCap = std::max(0.0, std::stod(value));
+                if (opts.pacing == PacingMode::UNCAPPED) opts.pacing = PacingMode::FPS_CAP;
+            }
+            else if (arg == "--max-frames-in-flight") {
+                opts.maxFramesInFlight = std::clamp(std::stoi(value), 1, 8);
+            }
+            else if (arg == "--texture-budget") {
+                opts.textureBudgetMB = static_cast<size_t>(std::max(1, std::stoi(value)));
+            }
+            else if (arg == "--texture-disk-cache") {
+                opts.textureDiskCacheMB = static_cast<size_t>(std::max(0, std::stoi(value)));
+            }
+            else if (arg == "--pass-formats") {
+                std::stringstream list(value);
+                std::string item;
+                while (std::getline(list, item, ',')) {
+                    GLenum format = ParseFormatName(item);
+                    if (!format) { std::cerr << "Unknown buffer format: " << item << "\n"; format = GL_RGBA32F; }
+                    opts.passFormats.push_back(format);
+                }
+            }
+            else if (arg == "--analyze-formats") {
+                opts.analyzeFrames = value.empty() ? 120 : std::max(1, std::stoi(value));
+            }
+            else if (arg == "--format-tolerance") {
+                opts.formatMinPsnr = std::stod(value);
+            }
+            else if (arg == "--format-max-error") {
+                opts.formatMaxError = std::stod(value);
+            }
+            else if (arg == "--control") {
+                opts.controlSocket = value.empty() ? "evolve_shader.sock" : value;
+            }
+            else if (arg == "--record") {
+                opts.recordPath = value.empty() ? "session.evrec" : value;
+            }
+            else if (arg == "--replay") {
+                opts.replayPath = value;
+            }
+            else if (arg == "--replay-timings") {
+                opts.replayTimingsPath = value;
+            }
+            else if (arg == "--skip-static-passes") {
+                opts.skipStaticPasses = true;
+            }
+            else if (arg == "--headless") {
+                opts.headless = true;
+            }
+            else if (arg == "--quality-tier") {
+                opts.qualityTier = value == "auto" ? -1 : std::max(0, std::stoi(value));
+            }
+            else if (arg == "--gpu-budget") {
+                opts.gpuBudgetMs = std::max(0.1, std::stod(value));
+            }
+            else if (arg == "--export") {
+                opts.exportPath = value.empty() ? "poster.png" : value;
+            }
+            else if (arg == "--export-size") {
+                size_t x = value.find_first_of("xX");
+                if (x == std::string::npos) throw std::invalid_argument(value);
+                opts.exportWidth = std::max(1, std::stoi(value.substr(0, x)));
+                opts.exportHeight = std::max(1, std::stoi(value.substr(x + 1)));
+            }
+            else if (arg == "--export-supersample") {
+                opts.exportSupersample = std::clamp(std::stoi(value), 1, 16);
+            }
+            else if (arg == "--export-tile") {
+                opts.exportTile = std::max(64, std::stoi(value));
+            }
+            else if (arg == "--export-dpi") {
+                opts.exportDpi = std::max(1, std::stoi(value));
+            }
+            else if (arg == "--export-depth") {
+                int depth = std::stoi(value);
+                if (depth == 8 || depth == 16) opts.exportBitDepth = depth;
+                else std::cerr << "--export-depth must be 8 or 16\n";
+            }
+            else if (arg == "--export-frame") {
+                opts.exportFrame = std::max(1, std::stoi(value));
+            }
+            else if (arg == "--view") {
+                ViewSpec view;
+                std::stringstream fields(value);
+                std::string field;
+                std::getline(fields, view.dir, ',');
+                while (std::getline(fields, field, ',')) {
+                    size_t x = field.find_first_of("xX");
+                    if (field == "headless") view.headless = true;
+                    else if (x != std::string::npos) {
+                        view.width = std::max(1, std::stoi(field.substr(0, x)));
+                        view.height = std::max(1, std::stoi(field.substr(x + 1)));
+                    }
+                    else throw std::invalid_argument(field);
+                }
+                if (view.dir.empty()) throw std::invalid_argument(value);
+                opts.views.push_back(view);
+            }
+            else if (arg == "--resize-feedback") {
+                if (value == "auto") opts.feedbackResample = FeedbackResample::AUTO;
+                else if (value == "stretch") opts.feedbackResample = FeedbackResample::STRETCH;
+                else if (value == "keep") opts.feedbackResample = FeedbackResample::KEEP;
+                else std::cerr << "Unknown --resize-feedback mode: " << value << "\n";
+            }
+            else {
+                std::cerr << "Unknown option: " << argv[i] << "\n";
+            }
+        }
+        catch (...) {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+        }
+    }
+    if (opts.pacing == PacingMode::FPS_CAP && opts.fpsCap <= 0.0) opts.fpsCap = 60.0;
+    if (opts.headless && opts.replayPath.empty()) {
+        std::cerr << "--headless only applies to --replay; ignoring\n";
+        opts.headless = false;
+    }
+    if (opts.headless) opts.pacing = PacingMode::UNCAPPED;
+    return opts;
+}
+
+// Start time for iTime
+std::chrono::steady_clock::time_point g_start;
+
+// Global frame counter (shared across all passes)
+int g_frame = 0;
+
+// Publish the current event-thread input state to the render thread
+void PushInputSnapshot(InputSnapshot::Source source) {
+    InputSnapshot snap;
+    snap.source = source;
+    snap.time = glfwGetTime();
+    snap.mouseX = g_mouseX;
+    snap.mouseY = g_mouseY;
+    snap.mouseDown = g_mouseDown;
+    snap.fbWidth = g_pendingWidth;
+    snap.fbHeight = g_pendingHeight;
+    g_inputPushFailed = !g_inputQueue.push(snap);
+    if (g_inputPushFailed) g_droppedSnapshot = snap;
+}
+
+// Retry a snapshot the queue had no room for. No event has arrived since (it would have
+// replaced it), so it still describes the current state.
+void RetryDroppedSnapshot() {
+    if (g_inputPushFailed) g_inputPushFailed = !g_inputQueue.push(g_droppedSnapshot);
+}
+
+// GLFW cursor callback
+void cursorPosCallback(GLFWwindow* window, double x, double y) {
+    g_mouseX = x;
+    g_mouseY = y;
+    PushInputSnapshot(InputSnapshot::MOUSE);
+}
+
+// GLFW mouse button callback
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    g_mouseDown = (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) ? 1 : 0;
+    PushInputSnapshot(InputSnapshot::MOUSE);
+}
+
+// Sleep until 'deadline' (glfwGetTime seconds) without overshooting.
+// The OS sleep granularity is learned online: we sleep in 1 ms steps while the
+// remaining time exceeds the estimated worst-case oversleep, then spin.
+void PreciseSleepUntil(double deadline) {
+    static double estimate = 0.005, mean = 0.005, m2 = 0.0;
+    static long long count = 1;
+
+    double now = glfwGetTime();
+    while (deadline - now > estimate) {
+        double start = now;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        now = glfwGetTime();
+        double observed = now - start;
+        ++count;
+        double delta = observed - mean;
+        mean += delta / count;
+        m2 += delta * (observed - mean);
+        estimate = mean + std::sqrt(m2 / (count - 1));
+    }
+    while (glfwGetTime() < deadline) std::this_thread::yield();
+}
+
+// Paces the render loop according to PacingMode and measures input-to-photon latency.
+// Every submitted frame gets a fence and a GPU timestamp query; once the fence signals,
+// the timestamp says when the frame left the GPU, independent of how late it is polled,
+// and the time since the freshest input it consumed is recorded as its latency.
+class FramePacer {
+public:
+    FramePacer(PacingMode mode, double fpsCap, int maxFramesInFlight)
+        : mode_(mode), fpsCap_(fpsCap), maxInFlight_(maxFramesInFlight) {
+        GLint bits = 0;
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        gpuTimestamps_ = bits > 0;
+        calibrateClock();
+    }
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+    ~FramePacer() {
+        for (auto& f : inFlight_) {
+            glDeleteSync(f.sync);
+            if (f.query) glDeleteQueries(1, &f.query);
+        }
+        if (!freeQueries_.empty()) glDeleteQueries(static_cast<GLsizei>(freeQueries_.size()), freeQueries_.data());
+    }
+
+    int swapInterval() const { return mode_ == PacingMode::VSYNC ? 1 : 0; }
+
+    // Block until this frame may start: frames in flight drop below the limit and
+    // the frame-rate cap has elapsed. Input should be sampled right after this returns.
+    void waitForFrameSlot() {
+        size_t limit = mode_ == PacingMode::LOW_LATENCY ? static_cast<size_t>(maxInFlight_) : kMaxTrackedFences;
+        while (inFlight_.size() >= limit) retire(true);
+
+        bool capped = mode_ == PacingMode::FPS_CAP || (mode_ == PacingMode::LOW_LATENCY && fpsCap_ > 0.0);
+        if (capped && fpsCap_ > 0.0) {
+            double period = 1.0 / fpsCap_;
+            if (nextFrameTime_ == 0.0) nextFrameTime_ = glfwGetTime();
+            PreciseSleepUntil(nextFrameTime_);
+            // Re-anchor after a long stall instead of bursting to catch up
+            nextFrameTime_ = std::max(nextFrameTime_ + period, glfwGetTime());
+        }
+        // After the sleep, so frames that finished during it are released now
+        while (!inFlight_.empty() && retire(false)) {}
+    }
+
+    // Call right after glfwSwapBuffers. inputTime < 0 means the frame consumed no new input.
+    void frameSubmitted(double inputTime) {
+        GLuint query = 0;
+        if (gpuTimestamps_ && inputTime >= 0.0) {
+            if (freeQueries_.empty()) {
+                glGenQueries(1, &query);
+            } else {
+                query = freeQueries_.back();
+                freeQueries_.pop_back();
+            }
+            glQueryCounter(query, GL_TIMESTAMP);
+        }
+        GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        if (sync) inFlight_.push_back({ sync, query, inputTime });
+        else if (query) freeQueries_.push_back(query);
+        if (mode_ == PacingMode::LOW_LATENCY) glFlush();
+    }
+
+    // Latency statistics since the last call, in milliseconds
+    bool takeLatencyStats(double& avgMs, double& maxMs) {
+        calibrateClock();  // the GPU and CPU clocks drift apart slowly
+        if (latencySamples_ == 0) return false;
+        avgMs = latencySum_ / latencySamples_ * 1000.0;
+        maxMs = latencyMax_ * 1000.0;
+        latencySum_ = latencyMax_ = 0.0;
+        latencySamples_ = 0;
+        return true;
+    }
+
+private:
+    static constexpr size_t kMaxTrackedFences = 8;
+
+    struct PendingFrame {
+        GLsync sync;
+        GLuint query;      // GL_TIMESTAMP issued right before the fence; 0 if none
+        double inputTime;
+    };
+
+    // Offset from GL_TIMESTAMP seconds to glfwGetTime()
+    void calibrateClock() {
+        if (!gpuTimestamps_) return;
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuToCpuOffset_ = glfwGetTime() - gpuNow / 1.0e9;
+    }
+
+    // Retire the oldest fence; returns false if it was not signaled (only when !block)
+    bool retire(bool block) {
+        PendingFrame& f = inFlight_.front();
+        GLuint64 timeout = block ? 100000000ull : 0;  // 100 ms guards against a lost context
+        GLenum r = glClientWaitSync(f.sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        if (r == GL_TIMEOUT_EXPIRED && !block) return false;
+        if (f.inputTime >= 0.0 && r != GL_WAIT_FAILED) {
+            double completed = glfwGetTime();
+            if (f.query && r != GL_TIMEOUT_EXPIRED) {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(f.query, GL_QUERY_RESULT, &ns);
+                completed = std::min(completed, ns / 1.0e9 + gpuToCpuOffset_);
+            }
+            double latency = std::max(0.0, completed - f.inputTime);
+            latencySum_ += latency;
+            latencyMax_ = std::max(latencyMax_, latency);
+            ++latencySamples_;
+        }
+        glDeleteSync(f.sync);
+        if (f.query) freeQueries_.push_back(f.query);
+        inFlight_.pop_front();
+        return true;
+    }
+
+    PacingMode mode_;
+    double fpsCap_;
+    int maxInFlight_;
+    double nextFrameTime_ = 0.0;
+    std::deque<PendingFrame> inFlight_;
+    std::vector<GLuint> freeQueries_;
+    bool gpuTimestamps_ = false;
+    double gpuToCpuOffset_ = 0.0;
+    double latencySum_ = 0.0, latencyMax_ = 0.0;
+    int latencySamples_ = 0;
+};
+
+// Non-blocking GPU timer: a ring of GL_TIME_ELAPSED queries read back a few frames later.
+// Each measurement carries a caller-supplied tag (usually the frame number).
+class GpuTimer {
+public:
+    GpuTimer() { glGenQueries(kRing, queries_); }
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+    ~GpuTimer() { glDeleteQueries(kRing, queries_); }
+
+    // onResult(tag, ms) is called for finished measurements, oldest first
+    template <typename F>
+    void begin(long long tag, F&& onResult) {
+        if (count_ == kRing) collect(onResult, true);  // ring full: wait for the oldest
+        int slot = (head_ + count_) % kRing;
+        tags_[slot] = tag;
+        glBeginQuery(GL_TIME_ELAPSED, queries_[slot]);
+    }
+
+    void end() {
+        glEndQuery(GL_TIME_ELAPSED);
+        ++count_;
+    }
+
+    template <typename F>
+    void collect(F&& onResult, bool waitForOne = false) {
+        while (count_ > 0) {
+            GLint available = 0;
+            glGetQueryObjectiv(queries_[head_], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available && !waitForOne) return;
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(queries_[head_], GL_QUERY_RESULT, &ns);
+            onResult(tags_[head_], ns / 1.0e6);
+            head_ = (head_ + 1) % kRing;
+            --count_;
+            waitForOne = false;
+        }
+    }
+
+private:
+    static constexpr int kRing = 8;
+    GLuint queries_[kRing] = {};
+    long long tags_[kRing] = {};
+    int head_ = 0;
+    int count_ = 0;
+};
+
+// Picks a quality tier from measured GPU time. Steps down as soon as the smoothed time
+// is over budget. Steps up only when the next tier's measured time fits with headroom; a
+// tier that was never measured, or whose measurement expired, is tried when the current
+// one uses less than half the budget. A measurement expires once the tier below has
+// become more than twice as cheap as when it was taken (the scene changed), so a tier
+// known to be too slow is never retried while the scene stays the same.
+class QualityController {
+public:
+    QualityController(int tiers, int initialTier, double budgetMs)
+        : budgetMs_(budgetMs), tier_(initialTier), tierMs_(tiers, -1.0), belowMs_(tiers, -1.0) {}
+
+    int tier() const { return tier_; }
+    double smoothedMs() const { return avgMs_; }
+
+    // 'frame' is the tag of the measured frame, 'nextFrame' the tag of the next frame to be
+    // rendered. Returns true when tier() changed.
+    bool addSample(long long frame, double ms, long long nextFrame) {
+        // Frames still in flight at the last switch used the old tier, and the first frames
+        // after it re-render static passes; neither says anything about the new tier
+        if (frame < settledFrame_) return false;
+        avgMs_ = samples_ == 0 ? ms : avgMs_ + kSmoothing * (ms - avgMs_);
+        if (++samples_ < kMinSamples) return false;
+        tierMs_[tier_] = avgMs_;
+        belowMs_[tier_] = tier_ > 0 ? tierMs_[tier_ - 1] : -1.0;
+        // A tier left before anything below it was known gets its reference from the first
+        // measurement after stepping down
+        if (tier_ + 1 < static_cast<int>(tierMs_.size()) && tierMs_[tier_ + 1] > 0.0 && belowMs_[tier_ + 1] < 0.0) {
+            belowMs_[tier_ + 1] = avgMs_;
+        }
+
+        if (avgMs_ > budgetMs_ && tier_ > 0) {
+            bool flapped = frame - lastUpgrade_ < 4 * kMinSamples;
+            holdFrames_ = flapped ? std::min(holdFrames_ * 2, kMaxHoldFrames) : kBaseHoldFrames;
+            upgradeAllowed_ = nextFrame + holdFrames_;
+            switchTo(tier_ - 1, nextFrame);
+            return true;
+        }
+        if (tier_ + 1 < static_cast<int>(tierMs_.size()) && frame >= upgradeAllowed_) {
+            double next = tierMs_[tier_ + 1];
+            double below = belowMs_[tier_ + 1];
+            bool measured = next > 0.0 && !(below > 0.0 && avgMs_ < 0.5 * below);
+            if (measured ? next < kUpgradeHeadroom * budgetMs_ : avgMs_ < 0.5 * budgetMs_) {
+                lastUpgrade_ = frame;
+                switchTo(tier_ + 1, nextFrame);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    static constexpr double kSmoothing = 0.1;
+    static constexpr double kUpgradeHeadroom = 0.85;
+    static constexpr int kMinSamples = 30;
+    static constexpr int kSettleFrames = 3;
+    static constexpr long long kBaseHoldFrames = 120;
+    static constexpr long long kMaxHoldFrames = 7680;
+
+    void switchTo(int t, long long nextFrame) {
+        tier_ = t;
+        samples_ = 0;
+        settledFrame_ = nextFrame + kSettleFrames;
+    }
+
+    double budgetMs_;
+    int tier_;
+    std::vector<double> tierMs_;       // last smoothed time seen per tier, -1 = never measured
+    std::vector<double> belowMs_;      // time of the tier below when tierMs_ was taken, -1 = unknown
+    double avgMs_ = 0.0;
+    int samples_ = 0;
+    long long settledFrame_ = kSettleFrames;
+    long long lastUpgrade_ = std::numeric_limits<long long>::min() / 2;
+    long long upgradeAllowed_ = 0;
+    long long holdFrames_ = kBaseHoldFrames;
+};
+
+// Handle window resize: only record the new size, GL work happens on the render thread
+void framebufferSizeCallback(GLFWwindow* window, int w, int h) {
+    g_pendingWidth = w;
+    g_pendingHeight = h;
+    PushInputSnapshot(InputSnapshot::RESIZE);
+}
+
+// Copy the contents of an old feedback buffer into a target of a different size
+void ResampleFeedback(const Framebuffer& src, Framebuffer& dst, bool stretch) {
+    int sw = src.colorTex.width, sh = src.colorTex.height;
+    int dw = dst.colorTex.width, dh = dst.colorTex.height;
+    dst.bind();
+    glViewport(0, 0, dst.width, dst.height);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, src.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst.fbo);
+    if (stretch) {
+        glBlitFramebuffer(0, 0, sw, sh, 0, 0, dw, dh, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    }
+    else {
+        int cw = std::min(sw, dw), ch = std::min(sh, dh);
+        glBlitFramebuffer(0, 0, cw, ch, 0, 0, cw, ch, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    Framebuffer::unbind();
+}
+
+// One shader chain: compiled passes, their channel wiring and render targets
+struct Pipeline {
+    // One program per quality tier for every pass, lowest quality first. Passes without
+    // '@quality' annotations have a single variant that serves every tier. Programs come
+    // from a ProgramCache and may be shared with other pipelines (see programsShared).
+    std::vector<std::vector<std::shared_ptr<GLProgram>>> variants;
+    std::vector<std::array<ChannelInput, 4>> channels;
+    std::vector<bool> keepTexelsOnResize;
+    std::vector<GLenum> formats;       // internal format of each pass's buffers
+    std::vector<Framebuffer> fbos;
+    std::vector<Framebuffer> history;  // Previous frame's output for feedback
+    std::vector<std::vector<CustomUniform>> params;  // '@param' uniforms of each pass
+    // A static pass doesn't depend on time, frame or mouse and only reads images or other
+    // static passes; it is re-rendered only when marked dirty
+    std::vector<bool> isStatic;
+    std::vector<bool> dirty;
+    int width = 0, height = 0;         // render size seen by the shaders
+    int tier = 0;                      // active quality tier
+    // Set when another pass, here or in another pipeline, uses one of this pipeline's
+    // program objects; uniform values live in the program, so custom uniforms are then
+    // uploaded on every draw (see MarkSharedPrograms)
+    bool programsShared = false;
+
+    size_t passCount() const { return variants.size(); }
+
+    int tierCount() const {
+        size_t n = 1;
+        for (const auto& v : variants) n = std::max(n, v.size());
+        return static_cast<int>(n);
+    }
+
+    const GLProgram& program(size_t pass) const {
+        const auto& v = variants[pass];
+        return *v[std::min(static_cast<size_t>(tier), v.size() - 1)];
+    }
+
+    // Switch every pass to another precompiled variant. Uniform values live in the
+    // program object, so custom uniforms are re-resolved and re-uploaded.
+    void setTier(int t) {
+        tier = std::clamp(t, 0, tierCount() - 1);
+        for (size_t i = 0; i < passCount(); ++i) {
+            for (auto& u : params[i]) {
+                u.location = program(i).getUniformLocation(u.name);
+                u.dirty = true;
+            }
+        }
+        markAllDirty();
+    }
+
+    void markAllDirty() { dirty.assign(passCount(), true); }
+};
+
+// Decide which passes are static. sources are the raw .frag contents, one per pass.
+// The check is textual, so a shader that varies through something it doesn't name (a
+// custom uniform fed with time, a macro built from other macros) would freeze; skipping
+// is therefore opt-in (--skip-static-passes) and every pass renders each frame otherwise.
+void ComputeStaticPasses(Pipeline& p, const std::vector<std::string>& sources, bool enabled) {
+    static const std::regex timeVarying(R"(\b(iTime|iTimeDelta|iFrame|iMouse|iDate)\b)");
+    size_t n = p.passCount();
+    p.isStatic.assign(n, false);
+    p.markAllDirty();
+    if (!enabled) return;
+    for (size_t i = 0; i < n; ++i) p.isStatic[i] = !std::regex_search(sources[i], timeVarying);
+    // A pass reading itself or any non-static buffer changes over time too; iterate to a fixpoint
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            if (!p.isStatic[i]) continue;
+            for (const auto& input : p.channels[i]) {
+                if (input.type != ChannelInput::BUFFER) continue;
+                int src = input.bufferIndex;
+                if (src == (int)i || src < 0 || src >= (int)n || !p.isStatic[src]) {
+                    p.isStatic[i] = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+    p.markAllDirty();
+}
+
+// Apply custom uniform updates from the control socket. Only values that actually
+// change are uploaded, and a change to a static pass schedules a re-render.
+void ApplyParamUpdates(Pipeline& p) {
+    ParamUpdate update;
+    while (g_paramQueue.pop(update)) {
+        if (update.pass < 0 || update.pass >= (int)p.params.size()) continue;
+        auto& params = p.params[update.pass];
+        if (update.index < 0 || update.index >= (int)params.size()) continue;
+        if (params[update.index].set(update.value, update.count)) p.dirty[update.pass] = true;
+    }
+}
+
+// Uniform inputs shared by every pass of one frame
+struct FrameParams {
+    float time = 0.0f;
+    float timeDelta = 0.0f;
+    float mouseX = 0.0f, mouseY = 0.0f;  // pixels, origin bottom-left
+    float mouseDown = 0.0f;
+};
+
+// Acquire cleared targets for every pass at w x h
+bool AllocatePipelineTargets(Pipeline& p, RenderTargetPool& pool, int w, int h) {
+    p.fbos.clear();
+    p.history.clear();
+    for (size_t i = 0; i < p.passCount(); ++i) {
+        p.fbos.push_back(pool.acquire(w, h, p.formats[i]));
+        p.history.push_back(pool.acquire(w, h, p.formats[i]));
+        if (!p.fbos.back().fbo || !p.history.back().fbo) return false;
+        p.history.back().bind();
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    Framebuffer::unbind();
+    p.width = w;
+    p.height = h;
+    p.markAllDirty();
+    return true;
+}
+
+// Reallocate every pass's targets at the new size from the pool, carrying feedback over.
+// If any target can't be allocated the pipeline keeps its current size and returns false;
+// a missing target would otherwise make its pass draw into the default framebuffer.
+bool ApplyResize(Pipeline& p, RenderTargetPool& pool, int w, int h) {
+    // Current outputs are fully rewritten every frame: recycle first so the same
+    // bucket can be handed straight back
+    for (auto& fb : p.fbos) pool.release(std::move(fb));
+    std::vector<Framebuffer> fbos, history;
+    bool ok = true;
+    for (size_t i = 0; i < p.fbos.size() && ok; ++i) {
+        fbos.push_back(pool.acquire(w, h, p.formats[i]));
+        history.push_back(pool.acquire(w, h, p.formats[i]));
+        ok = fbos.back().fbo && history.back().fbo;
+    }
+    if (!ok) {
+        std::cerr << "Resize to " << w << "x" << h << " failed, keeping " << p.width << "x" << p.height << "\n";
+        for (auto& fb : fbos) pool.release(std::move(fb));
+        for (auto& fb : history) pool.release(std::move(fb));
+        // The old outputs were just released, so these come straight back from the pool
+        for (size_t i = 0; i < p.fbos.size(); ++i) p.fbos[i] = pool.acquire(p.width, p.height, p.formats[i]);
+        p.markAllDirty();
+        return false;
+    }
+    for (size_t i = 0; i < p.fbos.size(); ++i) {
+        if (p.history[i].fbo) ResampleFeedback(p.history[i], history[i], !p.keepTexelsOnResize[i]);
+        pool.release(std::move(p.history[i]));
+    }
+    p.fbos = std::move(fbos);
+    p.history = std::move(history);
+    p.width = w;
+    p.height = h;
+    p.markAllDirty();
+    return true;
+}
+
+// Everything that varies per frame from the shaders' point of view. Recording these
+// and feeding them back reproduces a session exactly (given the same pipeline).
+struct FrameRecord {
+    float time;
+    float timeDelta;
+    int32_t frame;       // iFrame of the first pass
+    float mouseX;        // iMouse.xy as seen by the shaders (origin bottom-left)
+    float mouseY;
+    int32_t mouseDown;
+    int32_t width;       // render size (iResolution.xy)
+    int32_t height;
+    int32_t qualityTier; // active quality tier; -1 in version 1 recordings
+};
+static_assert(sizeof(FrameRecord) == 36, "FrameRecord is written to disk as-is");
+
+// Recording file: 16-byte header followed by one FrameRecord per frame (little-endian).
+// Version 1 records are 32 bytes, without the quality tier.
+struct RecordingHeader {
+    char magic[4] = { 'E', 'V', 'R', 'C' };
+    uint32_t version = 2;
+    uint32_t recordSize = sizeof(FrameRecord);
+    uint32_t reserved = 0;
+};
+
+class FrameRecorder {
+public:
+    bool open(const std::string& path) {
+        out_.open(path, std::ios::binary | std::ios::trunc);
+        if (!out_) {
+            std::cerr << "Failed to open recording file: " << path << "\n";
+            return false;
+        }
+        RecordingHeader header;
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return true;
+    }
+    bool isOpen() const { return out_.is_open(); }
+    void write(const FrameRecord& r) {
+        out_.write(reinterpret_cast<const char*>(&r), sizeof(r));
+        ++frames;
+    }
+    size_t frames = 0;
+
+private:
+    std::ofstream out_;
+};
+
+// Loads a whole recording up front so playback never touches the disk mid-run
+class FrameReplay {
+public:
+    bool load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        RecordingHeader header, expected;
+        if (!in || !in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, expected.magic, 4) != 0 ||
+            !((header.version == 1 && header.recordSize == offsetof(FrameRecord, qualityTier)) ||
+              (header.version == expected.version && header.recordSize == sizeof(FrameRecord)))) {
+            std::cerr << "Not a valid recording: " << path << "\n";
+            return false;
+        }
+        FrameRecord r;
+        r.qualityTier = -1;
+        while (in.read(reinterpret_cast<char*>(&r), header.recordSize)) records_.push_back(r);
+        std::cout << "Replaying " << records_.size() << " frame(s) from " << path << "\n";
+        return !records_.empty();
+    }
+    bool isLoaded() const { return !records_.empty(); }
+    bool next(FrameRecord& r) {
+        if (pos_ >= records_.size()) return false;
+        r = records_[pos_++];
+        return true;
+    }
+    size_t size() const { return records_.size(); }
+
+private:
+    std::vector<FrameRecord> records_;
+    size_t pos_ = 0;
+};
+
+// Per-frame GPU times collected during a replay, summarised at the end
+struct ReplayProfile {
+    std::vector<std::pair<long long, double>> frameMs;  // (frame index in recording, GPU ms)
+    double wallSeconds = 0.0;
+
+    void report(const std::string& csvPath) const {
+        if (frameMs.empty()) return;
+        double total = 0.0;
+        for (const auto& f : frameMs) total += f.second;
+        auto sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        std::vector<double> ms;
+        for (const auto& f : frameMs) ms.push_back(f.second);
+        std::sort(ms.begin(), ms.end());
+        char buf[256];
+        snprintf(buf, sizeof(buf), "[Replay] %zu frames in %.2f s wall | GPU avg %.3f ms, median %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            frameMs.size(), wallSeconds, total / frameMs.size(), ms[ms.size() / 2],
+            ms[std::min(ms.size() - 1, ms.size() * 99 / 100)], ms.back());
+        std::cout << buf << "[Replay] slowest frames:";
+        for (size_t i = 0; i < std::min<size_t>(5, sorted.size()); ++i) {
+            snprintf(buf, sizeof(buf), " #%lld (%.3f ms)", sorted[i].first, sorted[i].second);
+            std::cout << buf;
+        }
+        std::cout << "\n";
+        if (!csvPath.empty()) {
+            std::ofstream csv(csvPath);
+            csv << "frame,gpu_ms\n";
+            for (const auto& f : frameMs) csv << f.first << "," << f.second << "\n";
+            std::cout << "[Replay] per-frame timings written to " << csvPath << "\n";
+        }
+    }
+};
+
+// Use the program of pass i, set the Shadertoy uniforms for a resX x resY canvas and
+// bind its channel inputs
+const GLProgram& BindPassInputs(Pipeline& p, size_t i, const FrameParams& params, int frame,
+    int resX, int resY, const Texture& emptyTex, const std::vector<fs::path>& images) {
+    const GLProgram& program = p.program(i);
+    program.use();
+    glUniform3f(program.getUniformLocation("iResolution"), (float)resX, (float)resY, 1.0f);
+    glUniform1f(program.getUniformLocation("iTime"), params.time);
+    glUniform1f(program.getUniformLocation("iTimeDelta"), params.timeDelta);
+    glUniform1i(program.getUniformLocation("iFrame"), frame);
+    glUniform4f(program.getUniformLocation("iMouse"), params.mouseX, params.mouseY, params.mouseDown, 0.0f);
+    for (auto& u : p.params[i]) {
+        if (u.dirty || p.programsShared) u.upload();
+    }
+
+    auto& configForThis = p.channels[i];
+
+    for (int c = 0; c < 4; ++c) {
+        const ChannelInput& input = configForThis[c];
+        std::string name = "iChannel" + std::to_string(c);
+        GLint loc = program.getUniformLocation(name);
+        if (loc == -1) continue;
+
+        const Texture* texToBind = &emptyTex;
+        float uvScaleX = 1.0f, uvScaleY = 1.0f;
+
+        switch (input.type) {
+        case ChannelInput::NONE:
+            break;
+        case ChannelInput::IMAGE_GLOBAL:
+            if (input.imageIndex >= 0 && input.imageIndex < (int)images.size()) {
+                std::string imgPath = images[input.imageIndex].string();
+                texToBind = g_textureCache.get(imgPath);
+            }
+            break;
+        case ChannelInput::BUFFER: {
+            const Framebuffer& source = p.history[input.bufferIndex];  // Always read from previous frame
+            texToBind = &source.colorTex;
+            uvScaleX = (float)source.colorTex.width / source.width;
+            uvScaleY = (float)source.colorTex.height / source.height;
+            break;
+        }
+        }
+
+        texToBind->bind(c);
+        glUniform1i(loc, c);
+
+        std::string resName = "iChannelResolution[" + std::to_string(c) + "]";
+        GLint resLoc = program.getUniformLocation(resName);
+        if (resLoc != -1) {
+            glUniform3f(resLoc, (float)texToBind->width, (float)texToBind->height, 1.0f);
+        }
+        GLint scaleLoc = program.getUniformLocation("iChannelUVScale[" + std::to_string(c) + "]");
+        if (scaleLoc != -1) glUniform2f(scaleLoc, uvScaleX, uvScaleY);
+    }
+    return program;
+}
+
+// Render all passes once and copy their outputs into the feedback history.
+// The final pass goes to the default framebuffer (viewport screenW x screenH) unless
+// finalToScreen is false, in which case it is kept in its own buffer like the others.
+// Static passes that are not dirty keep last frame's output and are skipped.
+void RenderPipelineFrame(Pipeline& p, const FrameParams& params, const VertexArray& vao,
+    const Texture& emptyTex, const std::vector<fs::path>& images,
+    bool finalToScreen, int screenW, int screenH) {
+    int width = p.width;
+    int height = p.height;
+    std::vector<bool> rendered(p.passCount(), false);
+
+    // Render each pass
+    for (size_t i = 0; i < p.passCount(); ++i) {
+        int frame = g_frame++;
+        bool toScreen = finalToScreen && i == p.passCount() - 1;
+        if (!toScreen && p.isStatic[i] && !p.dirty[i]) continue;
+        p.dirty[i] = false;
+        rendered[i] = true;
+
+        BindPassInputs(p, i, params, frame, width, height, emptyTex, images);
+
+        // Set render target. Until a pending resize is applied the final pass is
+        // stretched over the live window so the image never shows a stale border
+        if (toScreen) {
+            Framebuffer::unbind();
+            glViewport(0, 0, screenW, screenH);
+        }
+        else {
+            p.fbos[i].bind();
+            glViewport(0, 0, width, height);
+        }
+
+        glClearColor(0, 0, 0, 1);
+        glClear(GL_COLOR_BUFFER_BIT);
+        vao.bind();
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        VertexArray::unbind();
+    }
+
+    // === Copy current FBO outputs to history using glCopyTexSubImage2D ===
+    for (size_t i = 0; i < p.fbos.size(); ++i) {
+        if (!rendered[i]) continue;
+        glBindTexture(GL_TEXTURE_2D, p.history[i].colorTex.id);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, p.fbos[i].fbo);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    }
+
+    // Buffers are read one frame late, so static readers of a pass that just
+    // re-rendered must render again next frame to pick up the new history
+    for (size_t k = 0; k < p.passCount(); ++k) {
+        if (!p.isStatic[k]) continue;
+        for (const auto& input : p.channels[k]) {
+            if (input.type == ChannelInput::BUFFER && input.bufferIndex >= 0 &&
+                input.bufferIndex < (int)rendered.size() && rendered[input.bufferIndex]) {
+                p.dirty[k] = true;
+            }
+        }
+    }
+}
+
+// Accumulated difference between two images
+struct ErrorStats {
+    double maxAbs = 0.0;
+    double sumSq = 0.0;
+    size_t count = 0;
+
+    double mse() const { return count ? sumSq / count : 0.0; }
+    double psnr(double peak = 1.0) const {
+        double m = mse();
+        return m > 0.0 ? 10.0 * std::log10(peak * peak / m) : std::numeric_limits<double>::infinity();
+    }
+};
+
+// Compare n floats of a against b. With clampUnit both sides are clamped to [0,1] first,
+// which is what the display sees. Squared errors are summed in float over short blocks
+// and flushed to double so long images don't lose precision.
+void AccumulateError(const float* a, const float* b, size_t n, bool clampUnit, ErrorStats& stats) {
+    const size_t kBlock = 4096;
+    float maxAbs = static_cast<float>(stats.maxAbs);
+    size_t i = 0;
+    while (i < n) {
+        size_t end = std::min(n, i + kBlock);
+        float blockSq = 0.0f;
+#ifdef EVOLVE_HAVE_SSE2
+        const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 vMax = _mm_set1_ps(maxAbs), vSq = _mm_setzero_ps();
+        for (; i + 4 <= end; i += 4) {
+            __m128 va = _mm_loadu_ps(a + i), vb = _mm_loadu_ps(b + i);
+            if (clampUnit) {
+                va = _mm_min_ps(_mm_max_ps(va, zero), one);
+                vb = _mm_min_ps(_mm_max_ps(vb, zero), one);
+            }
+            __m128 d = _mm_sub_ps(va, vb);
+            vMax = _mm_max_ps(vMax, _mm_and_ps(d, absMask));
+            vSq = _mm_add_ps(vSq, _mm_mul_ps(d, d));
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, vMax);
+        maxAbs = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+        _mm_store_ps(lanes, vSq);
+        blockSq = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+        for (; i < end; ++i) {
+            float va = a[i], vb = b[i];
+            if (clampUnit) { va = std::clamp(va, 0.0f, 1.0f); vb = std::clamp(vb, 0.0f, 1.0f); }
+            float d = va - vb;
+            maxAbs = std::max(maxAbs, std::fabs(d));
+            blockSq += d * d;
+        }
+        stats.sumSq += blockSq;
+    }
+    stats.maxAbs = maxAbs;
+    stats.count += n;
+}
+
+void ReadbackRGBA(const Framebuffer& fb, int w, int h, std::vector<float>& out) {
+    out.resize(static_cast<size_t>(w) * h * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fb.fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, w, h, GL_RGBA, GL_FLOAT, out.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+// Precision advisor: for every intermediate pass and every cheaper format, render the
+// pipeline for 'frames' frames twice in lockstep (all RGBA32F vs. that one pass changed)
+// with identical time and input, compare the final image each frame and time both runs.
+// Passes that feed back into themselves accumulate error over frames, so the verdict uses
+// the worst frame of the whole run rather than a single frame. Errors of several reduced
+// passes compound, so the combined suggestion is rendered and checked as well.
+void RunFormatAdvisor(Pipeline& p, RenderTargetPool& pool, const VertexArray& vao,
+    const Texture& emptyTex, const std::vector<fs::path>& images,
+    const std::vector<std::string>& passNames, const AppOptions& options) {
+    struct TargetSet {
+        std::vector<GLenum> formats;
+        std::vector<Framebuffer> fbos, history;
+    };
+    const int w = p.width, h = p.height;
+    const int frames = options.analyzeFrames;
+    const size_t N = p.passCount();
+    const size_t last = N - 1;
+
+    // Candidate targets come from the pool; the pipeline's own targets are left alone
+    auto allocate = [&](TargetSet& t, const std::vector<GLenum>& formats) {
+        t.formats = formats;
+        for (size_t i = 0; i < N; ++i) {
+            t.fbos.push_back(pool.acquire(w, h, formats[i]));
+            t.history.push_back(pool.acquire(w, h, formats[i]));
+            t.history.back().bind();
+            glClearColor(0, 0, 0, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        Framebuffer::unbind();
+    };
+    auto recycle = [&](TargetSet& t) {
+        for (auto& fb : t.fbos) pool.release(std::move(fb));
+        for (auto& fb : t.history) pool.release(std::move(fb));
+        t.fbos.clear();
+        t.history.clear();
+    };
+    // Render one frame into t and return its GPU time in ms
+    GLuint query = 0;
+    glGenQueries(1, &query);
+    auto renderWith = [&](TargetSet& t, const FrameParams& params) {
+        std::swap(p.fbos, t.fbos);
+        std::swap(p.history, t.history);
+        p.markAllDirty();  // static-pass skipping would compare stale buffers
+        g_textureCache.beginFrame();  // otherwise every texture stays pinned and none is evicted
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        RenderPipelineFrame(p, params, vao, emptyTex, images, false, w, h);
+        glEndQuery(GL_TIME_ELAPSED);
+        std::swap(p.fbos, t.fbos);
+        std::swap(p.history, t.history);
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &ns);
+        return ns / 1.0e6;
+    };
+
+    std::cout << "\n=== Buffer format advisor: " << frames << " frames at " << w << "x" << h
+        << ", tolerance PSNR >= " << options.formatMinPsnr << " dB, max error <= " << options.formatMaxError << " ===\n";
+    if (N < 2) std::cout << " Only one pass; its output goes straight to the screen. Nothing to analyze.\n";
+
+    struct Comparison {
+        ErrorStats worst, lastFrame;
+        double worstPsnr = std::numeric_limits<double>::infinity();
+        double refMs = 0.0, candMs = 0.0;
+        bool ok = false;
+    };
+    std::vector<float> refPixels, candPixels;
+    const std::vector<GLenum> reference(N, GL_RGBA32F);
+
+    // Render the all-RGBA32F reference and 'formats' in lockstep and compare the final images
+    auto compare = [&](const std::vector<GLenum>& formats) {
+        Comparison result;
+        TargetSet ref, cand;
+        allocate(ref, reference);
+        allocate(cand, formats);
+        for (int f = 0; f < frames; ++f) {
+            FrameParams params;
+            params.time = f / 60.0f;
+            params.timeDelta = 1.0f / 60.0f;
+            params.mouseX = w * 0.5f;
+            params.mouseY = h * 0.5f;
+
+            g_frame = f * static_cast<int>(N);
+            result.refMs += renderWith(ref, params);
+            g_frame = f * static_cast<int>(N);
+            result.candMs += renderWith(cand, params);
+
+            ReadbackRGBA(ref.fbos[last], w, h, refPixels);
+            ReadbackRGBA(cand.fbos[last], w, h, candPixels);
+            ErrorStats frameStats;
+            AccumulateError(refPixels.data(), candPixels.data(), refPixels.size(), true, frameStats);
+            result.worst.maxAbs = std::max(result.worst.maxAbs, frameStats.maxAbs);
+            result.worstPsnr = std::min(result.worstPsnr, frameStats.psnr());
+            result.lastFrame = frameStats;
+        }
+        recycle(ref);
+        recycle(cand);
+        result.ok = result.worstPsnr >= options.formatMinPsnr && result.worst.maxAbs <= options.formatMaxError;
+        return result;
+    };
+    auto printComparison = [&](const char* label, const Comparison& c) {
+        char line[256];
+        snprintf(line, sizeof(line),
+            "   %-8s max err %.5f  PSNR worst %6.1f dB, last frame %6.1f dB  GPU %.3f ms vs %.3f ms (saves %.3f ms/frame)  %s\n",
+            label, c.worst.maxAbs, c.worstPsnr, c.lastFrame.psnr(),
+            c.candMs / frames, c.refMs / frames, (c.refMs - c.candMs) / frames, c.ok ? "OK" : "too lossy");
+        std::cout << line;
+    };
+
+    const GLenum candidates[] = { GL_RGBA8, GL_RGBA16F };  // cheapest first
+    std::vector<GLenum> recommended(N, GL_RGBA32F);
+    std::vector<double> recommendedPsnr(N, std::numeric_limits<double>::infinity());
+
+    for (size_t pass = 0; pass < last; ++pass) {
+        bool feedback = false;
+        for (const auto& input : p.channels[pass]) {
+            if (input.type == ChannelInput::BUFFER && input.bufferIndex >= (int)pass) feedback = true;
+        }
+        std::cout << " pass " << pass << " (" << passNames[pass] << ")"
+            << (feedback ? " [feedback: judged over accumulated frames]" : "") << "\n";
+
+        for (GLenum format : candidates) {
+            std::vector<GLenum> formats = reference;
+            formats[pass] = format;
+            Comparison c = compare(formats);
+            if (c.ok && BytesPerTexel(format) < BytesPerTexel(recommended[pass])) {
+                recommended[pass] = format;
+                recommendedPsnr[pass] = c.worstPsnr;
+            }
+            printComparison(FormatName(format), c);
+        }
+        std::cout << "   -> " << FormatName(recommended[pass]) << "\n";
+    }
+
+    // Check the combination. While it is too lossy, give the reduced pass with the lowest
+    // individual PSNR one more step of precision (8 -> 16F -> 32F) and measure again.
+    size_t reduced = std::count_if(recommended.begin(), recommended.end(), [](GLenum f) { return f != GL_RGBA32F; });
+    if (reduced > 1) {
+        std::cout << " combined\n";
+        while (true) {
+            Comparison c = compare(recommended);
+            printComparison("combined", c);
+            if (c.ok) break;
+            size_t weakest = N;
+            for (size_t i = 0; i < N; ++i) {
+                if (recommended[i] == GL_RGBA32F) continue;
+                if (weakest == N || recommendedPsnr[i] < recommendedPsnr[weakest]) weakest = i;
+            }
+            if (weakest == N) break;
+            recommended[weakest] = recommended[weakest] == GL_RGBA8 ? GL_RGBA16F : GL_RGBA32F;
+            recommendedPsnr[weakest] = std::numeric_limits<double>::infinity();
+            std::cout << "   raising pass " << weakest << " to " << FormatName(recommended[weakest]) << "\n";
+        }
+    }
+    glDeleteQueries(1, &query);
+    g_frame = 0;
+    p.markAllDirty();
+
+    std::cout << " Suggested: --pass-formats=";
+    for (size_t i = 0; i < N; ++i) {
+        GLenum f = recommended[i];
+        std::cout << (f == GL_RGBA8 ? "8" : f == GL_RGBA16F ? "16f" : "32f") << (i + 1 < N ? "," : "\n");
+    }
+}
+
+// Simple fullscreen quad vertex shader
+const char* vertShaderSrc = R"GLSL(
+#version 330 core
+layout(location=0) in vec2 aPos;
+layout(location=1) in vec2 aTex;
+out vec2 vTex;
+void main() {
+    vTex = aTex;
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+)GLSL";
+
+// Linked programs keyed by their complete fragment source. Passes that come out identical
+// (same file, parameters and quality tier) are compiled once, and every context in the
+// share group uses the same program object.
+class ProgramCache {
+public:
+    size_t hits = 0;
+
+    std::shared_ptr<GLProgram> get(const std::string& fragSource) {
+        auto it = programs_.find(fragSource);
+        if (it != programs_.end()) {
+            ++hits;
+            return it->second;
+        }
+        auto program = std::make_shared<GLProgram>(vertShaderSrc, fragSource.c_str());
+        programs_.emplace(fragSource, program);
+        return program;
+    }
+
+    size_t size() const { return programs_.size(); }
+    void clear() { programs_.clear(); }
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<GLProgram>> programs_;
+};
+
+// Writes an RGB image one row at a time, top row first, so arbitrarily large images never
+// have to exist in memory. '.tif'/'.tiff' produce an uncompressed single-strip TIFF (up to
+// 4 GB); anything else produces a PNG whose zlib stream uses stored (uncompressed) deflate
+// blocks, which needs no compression library and has no size limit.
+// Rows hold width * 3 samples of uint8_t or, at 16 bits, host-order uint16_t.
+class ImageRowWriter {
+public:
+    ImageRowWriter() = default;
+    ImageRowWriter(const ImageRowWriter&) = delete;
+    ImageRowWriter& operator=(const ImageRowWriter&) = delete;
+
+    // dpi is stored as the print resolution (TIFF XResolution/YResolution, PNG pHYs)
+    bool open(const std::string& path, int width, int height, int bitDepth, int dpi = 300) {
+        std::string ext = fs::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+        tiff_ = ext == ".tif" || ext == ".tiff";
+        width_ = width;
+        height_ = height;
+        bitDepth_ = bitDepth;
+        dpi_ = std::max(1, dpi);
+        rowBytes_ = static_cast<size_t>(width) * 3 * (bitDepth / 8);
+        if (tiff_ && static_cast<uint64_t>(rowBytes_) * height > 0xFFFFFF00ull) {
+            std::cerr << "Image too large for TIFF (4 GB limit), use .png: " << path << "\n";
+            return false;
+        }
+        file_.open(path, std::ios::binary);
+        if (!file_) {
+            std::cerr << "Failed to create image file: " << path << "\n";
+            return false;
+        }
+        if (tiff_) writeTiffHeader();
+        else writePngHeader();
+        return static_cast<bool>(file_);
+    }
+
+    bool writeRow(const void* samples) {
+        const uint8_t* row = static_cast<const uint8_t*>(samples);
+        if (tiff_) {
+            // TIFF is written little-endian ("II"), which is what x86/ARM hosts store anyway
+            if (bitDepth_ == 16 && !HostIsLittleEndian()) {
+                swapped_.assign(row, row + rowBytes_);
+                for (size_t i = 0; i + 1 < rowBytes_; i += 2) std::swap(swapped_[i], swapped_[i + 1]);
+                row = swapped_.data();
+            }
+            file_.write(reinterpret_cast<const char*>(row), rowBytes_);
+        }
+        else {
+            // PNG scanline: filter type 0, then big-endian samples
+            raw_.push_back(0);
+            size_t start = raw_.size();
+            raw_.insert(raw_.end(), row, row + rowBytes_);
+            if (bitDepth_ == 16 && HostIsLittleEndian()) {
+                for (size_t i = start; i + 1 < raw_.size(); i += 2) std::swap(raw_[i], raw_[i + 1]);
+            }
+            while (raw_.size() >= kStoredBlock) emitStoredBlock(kStoredBlock, false);
+        }
+        ++rowsWritten_;
+        return static_cast<bool>(file_);
+    }
+
+    // Completes the file; returns false if rows are missing or a write failed
+    bool finish() {
+        if (!tiff_) {
+            emitStoredBlock(raw_.size(), true);
+            uint32_t adler = (adlerB_ << 16) | adlerA_;
+            PutBE32(idat_, adler);
+            flushIdat();
+            writeChunk("IEND", nullptr, 0);
+        }
+        file_.close();
+        return rowsWritten_ == height_ && !file_.fail();
+    }
+
+private:
+    static constexpr size_t kStoredBlock = 65535;         // largest stored deflate block
+    static constexpr size_t kIdatChunk = 1u << 20;
+
+    static bool HostIsLittleEndian() {
+        const uint16_t one = 1;
+        return *reinterpret_cast<const uint8_t*>(&one) == 1;
+    }
+    static void PutBE32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int s = 24; s >= 0; s -= 8) out.push_back(static_cast<uint8_t>(v >> s));
+    }
+    static void PutLE16(std::vector<uint8_t>& out, uint16_t v) {
+        out.push_back(static_cast<uint8_t>(v));
+        out.push_back(static_cast<uint8_t>(v >> 8));
+    }
+    static void PutLE32(std::vector<uint8_t>& out, uint32_t v) {
+        for (int s = 0; s < 32; s += 8) out.push_back(static_cast<uint8_t>(v >> s));
+    }
+
+    static uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t n) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < n; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void writeChunk(const char* type, const uint8_t* data, size_t n) {
+        std::vector<uint8_t> head;
+        PutBE32(head, static_cast<uint32_t>(n));
+        head.insert(head.end(), type, type + 4);
+        uint32_t crc = Crc32(Crc32(0, head.data() + 4, 4), data, n);
+        std::vector<uint8_t> tail;
+        PutBE32(tail, crc);
+        file_.write(reinterpret_cast<const char*>(head.data()), head.size());
+        if (n) file_.write(reinterpret_cast<const char*>(data), n);
+        file_.write(reinterpret_cast<const char*>(tail.data()), tail.size());
+    }
+
+    void writePngHeader() {
+        static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        file_.write(reinterpret_cast<const char*>(signature), 8);
+        std::vector<uint8_t> ihdr;
+        PutBE32(ihdr, static_cast<uint32_t>(width_));
+        PutBE32(ihdr, static_cast<uint32_t>(height_));
+        ihdr.push_back(static_cast<uint8_t>(bitDepth_));
+        ihdr.push_back(2);  // truecolor RGB
+        ihdr.push_back(0);  // deflate
+        ihdr.push_back(0);  // adaptive filtering
+        ihdr.push_back(0);  // no interlace
+        writeChunk("IHDR", ihdr.data(), ihdr.size());
+        std::vector<uint8_t> phys;
+        uint32_t pixelsPerMeter = static_cast<uint32_t>(std::lround(dpi_ / 0.0254));
+        PutBE32(phys, pixelsPerMeter);
+        PutBE32(phys, pixelsPerMeter);
+        phys.push_back(1);  // unit: meter
+        writeChunk("pHYs", phys.data(), phys.size());
+        idat_ = { 0x78, 0x01 };  // zlib header: deflate, 32K window, no preset dictionary
+    }
+
+    // Move n bytes of pending scanline data into the zlib stream as one stored block
+    void emitStoredBlock(size_t n, bool final) {
+        idat_.push_back(final ? 1 : 0);
+        PutLE16(idat_, static_cast<uint16_t>(n));
+        PutLE16(idat_, static_cast<uint16_t>(~n));
+        idat_.insert(idat_.end(), raw_.begin(), raw_.begin() + n);
+        for (size_t i = 0; i < n; ++i) {
+            adlerA_ = (adlerA_ + raw_[i]) % 65521u;
+            adlerB_ = (adlerB_ + adlerA_) % 65521u;
+        }
+        raw_.erase(raw_.begin(), raw_.begin() + n);
+        if (idat_.size() >= kIdatChunk) flushIdat();
+    }
+
+    void flushIdat() {
+        if (idat_.empty()) return;
+        writeChunk("IDAT", idat_.data(), idat_.size());
+        idat_.clear();
+    }
+
+    // Header and IFD go first; the single strip of pixel data follows and is streamed
+    void writeTiffHeader() {
+        const uint16_t kEntries = 13;
+        const uint32_t ifdOffset = 8;
+        const uint32_t bitsOffset = ifdOffset + 2 + kEntries * 12 + 4;
+        const uint32_t resolutionOffset = bitsOffset + 6 + 2;  // two RATIONALs, word-aligned
+        const uint32_t dataOffset = resolutionOffset + 16;
+        const uint32_t dataBytes = static_cast<uint32_t>(rowBytes_ * height_);
+
+        std::vector<uint8_t> h = { 'I', 'I', 42, 0 };
+        PutLE32(h, ifdOffset);
+        PutLE16(h, kEntries);
+        auto entry = [&](uint16_t tag, uint16_t type, uint32_t count, uint32_t value) {
+            PutLE16(h, tag);
+            PutLE16(h, type);
+            PutLE32(h, count);
+            if (type == 3 && count == 1) { PutLE16(h, static_cast<uint16_t>(value)); PutLE16(h, 0); }
+            else PutLE32(h, value);
+        };
+        const uint16_t SHORT = 3, LONG = 4, RATIONAL = 5;
+        entry(256, LONG, 1, static_cast<uint32_t>(width_));    // ImageWidth
+        entry(257, LONG, 1, static_cast<uint32_t>(height_));   // ImageLength
+        entry(258, SHORT, 3, bitsOffset);                       // BitsPerSample
+        entry(259, SHORT, 1, 1);                                // Compression: none
+        entry(262, SHORT, 1, 2);                                // Photometric: RGB
+        entry(273, LONG, 1, dataOffset);                        // StripOffsets
+        entry(277, SHORT, 1, 3);                                // SamplesPerPixel
+        entry(278, LONG, 1, static_cast<uint32_t>(height_));   // RowsPerStrip
+        entry(279, LONG, 1, dataBytes);                         // StripByteCounts
+        entry(282, RATIONAL, 1, resolutionOffset);              // XResolution
+        entry(283, RATIONAL, 1, resolutionOffset + 8);          // YResolution
+        entry(284, SHORT, 1, 1);                                // PlanarConfiguration: chunky
+        entry(296, SHORT, 1, 2);                                // ResolutionUnit: inch
+        PutLE32(h, 0);                                          // no further IFDs
+        for (int c = 0; c < 3; ++c) PutLE16(h, static_cast<uint16_t>(bitDepth_));
+        PutLE16(h, 0);
+        for (int axis = 0; axis < 2; ++axis) {
+            PutLE32(h, static_cast<uint32_t>(dpi_));
+            PutLE32(h, 1);
+        }
+        file_.write(reinterpret_cast<const char*>(h.data()), h.size());
+    }
+
+    std::ofstream file_;
+    bool tiff_ = false;
+    int width_ = 0, height_ = 0, bitDepth_ = 8, dpi_ = 300;
+    size_t rowBytes_ = 0;
+    int rowsWritten_ = 0;
+    std::vector<uint8_t> raw_, idat_, swapped_;
+    uint32_t adlerA_ = 1, adlerB_ = 0;
+};
+
+// Poster export: the final pass is rendered over a virtual W x H canvas as a grid of tiles.
+// iResolution reports the whole canvas and iTileRect shifts fragCoord to each tile, so the
+// shader cannot tell the difference. Every tile is rendered with N x N samples per pixel,
+// box-filtered on the GPU (in linear space, clamped like the display), read back and
+// copied into a band of rows that is streamed to the image file. CPU memory is one band,
+// GPU memory one supersampled tile, whatever the poster size.
+// Earlier passes are not re-rendered: their buffers keep the window resolution and are
+// sampled by the final pass as usual.
+const char* kDownfilterFragSrc = R"GLSL(
+#version 330 core
+out vec4 fragColor;
+uniform sampler2D uSource;
+uniform int uFactor;
+uniform bool uEncodeSrgb;
+void main() {
+    ivec2 base = ivec2(gl_FragCoord.xy) * uFactor;
+    vec3 sum = vec3(0.0);
+    for (int y = 0; y < uFactor; ++y)
+        for (int x = 0; x < uFactor; ++x)
+            sum += clamp(texelFetch(uSource, base + ivec2(x, y), 0).rgb, 0.0, 1.0);
+    vec3 c = sum / float(uFactor * uFactor);
+    if (uEncodeSrgb) c = mix(c * 12.92, 1.055 * pow(c, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, c));
+    fragColor = vec4(c, 1.0);
+}
+)GLSL";
+
+const size_t kExportTileBytes = 64u * 1024u * 1024u;
+
+bool ExportPoster(Pipeline& p, const std::string& path, const AppOptions& options, FrameParams params,
+    const VertexArray& vao, const Texture& emptyTex, const std::vector<fs::path>& images, bool encodeSrgb) {
+    const int W = options.exportWidth > 0 ? options.exportWidth : p.width * 4;
+    const int H = options.exportHeight > 0 ? options.exportHeight : p.height * 4;
+    const int N = options.exportSupersample;
+    const int bytesPerSample = options.exportBitDepth / 8;
+    const size_t rowBytes = static_cast<size_t>(W) * 3 * bytesPerSample;
+    const size_t kBandBudget = 64u * 1024u * 1024u;
+
+    const size_t last = p.passCount() - 1;
+
+    // Supersampled tile edge: by default the largest power of two whose tile in the final
+    // pass's format fits kExportTileBytes (2048 for RGBA32F), and never beyond the texture
+    // and viewport limits. The band of rows kept in memory gets shorter as the poster widens.
+    int tileEdge = options.exportTile;
+    if (tileEdge <= 0) {
+        tileEdge = 4096;
+        while (tileEdge > 256 && static_cast<size_t>(tileEdge) * tileEdge * BytesPerTexel(p.formats[last]) > kExportTileBytes) {
+            tileEdge /= 2;
+        }
+    }
+    GLint maxTexture = 0, maxViewport[2] = {};
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexture);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+    int maxRender = std::min({ tileEdge, (int)maxTexture, (int)maxViewport[0], (int)maxViewport[1] });
+    int tileW = std::max(1, std::min(W, maxRender / N));
+    int tileH = std::max(1, std::min({ H, maxRender / N, (int)std::max<size_t>(1, kBandBudget / rowBytes) }));
+
+    Framebuffer samples, filtered;
+    if (!samples.create(tileW * N, tileH * N, p.formats[last]) ||
+        !filtered.create(tileW, tileH, options.exportBitDepth == 16 ? GL_RGBA16 : GL_RGBA8)) {
+        std::cerr << "[Export] failed to create " << tileW * N << "x" << tileH * N << " tile targets\n";
+        return false;
+    }
+    GLProgram downfilter(vertShaderSrc, kDownfilterFragSrc);
+
+    ImageRowWriter writer;
+    if (!writer.open(path, W, H, options.exportBitDepth, options.exportDpi)) return false;
+    int cols = (W + tileW - 1) / tileW, rows = (H + tileH - 1) / tileH;
+    std::cout << "[Export] " << W << "x" << H << " (" << N << "x" << N << " supersampling) as "
+              << cols << "x" << rows << " tiles of " << tileW << "x" << tileH << " -> " << path << "\n";
+
+    // The mouse position is in window pixels; scale it onto the canvas
+    params.mouseX *= (float)W / p.width;
+    params.mouseY *= (float)H / p.height;
+
+    std::vector<uint8_t> band(rowBytes * tileH), tile(static_cast<size_t>(tileW) * tileH * 3 * bytesPerSample);
+    GLenum readType = options.exportBitDepth == 16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    bool ok = true;
+    int nextPercent = 10;
+
+    // Bands run from the top of the canvas down, matching the file's row order
+    for (int r = 0; r < rows && ok; ++r) {
+        int bandTop = H - r * tileH;             // canvas y (origin bottom-left) above the band
+        int bandRows = std::min(tileH, bandTop);
+        for (int c = 0; c < cols; ++c) {
+            int x0 = c * tileW;
+            int tileCols = std::min(tileW, W - x0);
+
+            const GLProgram& program = BindPassInputs(p, last, params, g_frame, W, H, emptyTex, images);
+            glUniform4f(program.getUniformLocation("iTileRect"),
+                (float)x0, (float)(bandTop - tileH), (float)tileW, (float)tileH);
+            samples.bind();
+            glViewport(0, 0, tileW * N, tileH * N);
+            vao.bind();
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+
+            downfilter.use();
+            samples.colorTex.bind(0);
+            glUniform1i(downfilter.getUniformLocation("uSource"), 0);
+            glUniform1i(downfilter.getUniformLocation("uFactor"), N);
+            glUniform1i(downfilter.getUniformLocation("uEncodeSrgb"), encodeSrgb ? 1 : 0);
+            filtered.bind();
+            glViewport(0, 0, tileW, tileH);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            VertexArray::unbind();
+
+            // The top bandRows rows of the tile, bottom-up from GL, flipped into the band
+            glReadPixels(0, tileH - bandRows, tileCols, bandRows, GL_RGB, readType, tile.data());
+            size_t tileRowBytes = static_cast<size_t>(tileCols) * 3 * bytesPerSample;
+            for (int y = 0; y < bandRows; ++y) {
+                std::memcpy(&band[(bandRows - 1 - y) * rowBytes + static_cast<size_t>(x0) * 3 * bytesPerSample],
+                    &tile[y * tileRowBytes], tileRowBytes);
+            }
+        }
+        for (int y = 0; y < bandRows && ok; ++y) ok = writer.writeRow(&band[y * rowBytes]);
+
+        int percent = (r + 1) * 100 / rows;
+        if (percent >= nextPercent && r + 1 < rows) {
+            std::cout << "[Export] " << percent << "%\n";
+            nextPercent = percent / 10 * 10 + 10;
+        }
+    }
+    Framebuffer::unbind();
+
+    // Back to whole-canvas rendering for the next regular frame
+    const GLProgram& program = p.program(last);
+    program.use();
+    glUniform4f(program.getUniformLocation("iTileRect"), 0.0f, 0.0f, 0.0f, 0.0f);
+
+    ok = writer.finish() && ok;
+    std::cout << (ok ? "[Export] done: " : "[Export] failed: ") << path << "\n";
+    return ok;
+}
+
+// Scan a shader directory ('frag' by default) for .frag files, sorted by number prefix
+std::vector<std::string> ScanShaderFiles(const fs::path& dir = "frag") {
+    std::vector<std::pair<int, fs::path>> entries;
+    for (const auto& entry : fs::directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".frag") {
+            std::string stem = entry.path().stem().string();
+            std::regex numPattern(R"((\d+))");
+            std::smatch match;
+            if (std::regex_search(stem, match, numPattern)) {
+                entries.emplace_back(std::stoi(match[1]), entry.path());
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    std::vector<std::string> result;
+    for (auto& [idx, path] : entries) result.push_back(path.string());
+    return result;
+}
+
+// Interactive setup for iChannel connections
+std::vector<std::array<ChannelInput, 4>> ConfigureChannelsInteractively(
+    const std::vector<std::string>& files,
+    const std::vector<fs::path>& globalImages) {
+
+    int N = static_cast<int>(files.size());
+    std::vector<std::array<ChannelInput, 4>> configs(N);
+    for (auto& chs : configs) for (int i = 0; i < 4; ++i) chs[i].type = ChannelInput::NONE;
+
+    std::cout << "\n=== Interactive iChannel Setup ===\n";
+    std::cout << " Press Enter for auto-chain (buffer0 → buffer1 → ...),\n";
+    std::cout << " or type a buffer index to configure manually: ";
+
+    std::string line;
+    std::getline(std::cin, line);
+
+    if (line.empty()) {
+        std::cout << " Auto-chain: ";
+        for (int i = 1; i < N; ++i) {
+            configs[i][0].type = ChannelInput::BUFFER;
+            configs[i][0].bufferIndex = i - 1;
+            std::cout << "buffer" << i - 1 << " → ";
+        }
+        if (N > 0) std::cout << "buffer" << N - 1 << "\n\n";
+        return configs;
+    }
+
+    while (true) {
+        try {
+            int idx = std::stoi(line);
+            if (idx < 0 || idx >= N) {
+                std::cout << " Invalid index. Choose 0-" << N - 1 << ": ";
+                std::getline(std::cin, line);
+                continue;
+            }
+            std::string fname = fs::path(files[idx]).filename().string();
+            std::cout << "\n Configuring buffer" << idx << " (" << fname << "):\n";
+            for (int c = 0; c < 4; ++c) {
+                std::cout << "\niChannel" << c << " source:\n";
+                std::cout << "  1: none\n";
                 std::cout << "  2: self (feedback)\n";
                 for (int b = 0; b < N; ++b) {
                     if (b == idx) continue;
@@ -521,7 +2886,378 @@ std::vector<std::array<ChannelInput, 4>> ConfigureChannelsInteractively(
     return configs;
 }
 
-int main() {
+// Load and compile every pass of one pipeline. Programs come from the cache, so passes
+// that several pipelines have in common are compiled once.
+bool BuildPipeline(Pipeline& pipeline, const std::vector<std::string>& fragFiles,
+    const std::vector<std::array<ChannelInput, 4>>& channels, const AppOptions& options,
+    ProgramCache& programCache, std::vector<std::string>& passNames, std::vector<std::string>& passSources) {
+    for (const auto& file : fragFiles) {
+        std::string code = LoadShaderFile(file);
+        if (code.empty()) continue;
+        passNames.push_back(fs::path(file).filename().string());
+        passSources.push_back(code);
+        if (options.bucketedTargets) code = ScaleChannelSampling(code);
+        bool keep = options.feedbackResample == FeedbackResample::KEEP ||
+            (options.feedbackResample == FeedbackResample::AUTO && code.find("texelFetch") != std::string::npos);
+        pipeline.keepTexelsOnResize.push_back(keep);
+        size_t pass = pipeline.passCount();
+        pipeline.formats.push_back(pass < options.passFormats.size() ? options.passFormats[pass] : GL_RGBA32F);
+        auto params = ParseCustomUniforms(code);
+        std::string decls = CustomUniformDeclarations(params);
+
+        // Every quality tier is compiled up front so switching later costs nothing
+        auto quality = ParseQualityDefines(code);
+        int tiers = QualityTierCount(quality);
+        std::vector<std::shared_ptr<GLProgram>> variants;
+        for (int t = 0; t < tiers; ++t) {
+            std::string defineBlock;
+            std::string variant = ApplyQualityTier(code, quality, t, defineBlock);
+            variants.push_back(programCache.get(WrapShadertoyShader(variant, defineBlock + decls)));
+        }
+        if (tiers > 1) std::cout << "  " << passNames.back() << ": " << tiers << " quality tiers\n";
+        pipeline.variants.push_back(std::move(variants));
+        pipeline.params.push_back(std::move(params));
+    }
+    if (pipeline.passCount() == 0) return false;
+    pipeline.channels = channels;
+    ComputeStaticPasses(pipeline, passSources, options.skipStaticPasses);
+    // Start at the pinned tier, otherwise at the highest and let the controller step down
+    pipeline.setTier(options.qualityTier >= 0 ? options.qualityTier : pipeline.tierCount() - 1);
+    return true;
+}
+
+// Sets programsShared on exactly those pipelines that hold a program also used by a
+// different pass. Quality tiers of one pass that compile to the same program don't count:
+// they carry the same uniform values.
+void MarkSharedPrograms(const std::vector<Pipeline*>& pipelines) {
+    std::unordered_map<const GLProgram*, std::pair<const Pipeline*, size_t>> firstUser;
+    std::unordered_set<const GLProgram*> shared;
+    for (const Pipeline* p : pipelines) {
+        for (size_t pass = 0; pass < p->passCount(); ++pass) {
+            for (const auto& program : p->variants[pass]) {
+                auto user = std::make_pair(p, pass);
+                auto it = firstUser.emplace(program.get(), user).first;
+                if (it->second != user) shared.insert(program.get());
+            }
+        }
+    }
+    for (Pipeline* p : pipelines) {
+        p->programsShared = false;
+        for (const auto& variants : p->variants) {
+            for (const auto& program : variants) {
+                if (shared.count(program.get())) p->programsShared = true;
+            }
+        }
+    }
+}
+
+// Attribute layout of the fullscreen quad. VAOs are not shared between contexts, so each
+// window context gets its own VAO over the one shared vertex buffer.
+void SetupQuadVertexArray(const VertexArray& vao, const VertexBuffer& vbo) {
+    vao.bind(); vbo.bind();
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    VertexArray::unbind();
+}
+
+// Multi-view mode: several pipelines, each in its own window or offscreen, rendered
+// round-robin by one thread. Every window context shares with the main window, so
+// programs (ProgramCache), image textures (g_textureCache), the quad's vertex buffer and
+// the empty texture exist once; render targets, VAOs and timer queries are per view.
+struct View {
+    std::string name;
+    GLFWwindow* window = nullptr;       // null: offscreen, drawn in the main window's context
+    GLFWwindow* context = nullptr;      // context owning this view's FBOs, VAO and queries
+    Pipeline pipeline;
+    RenderTargetPool pool;
+    std::unique_ptr<VertexArray> ownVao;  // secondary windows only
+    const VertexArray* vao = nullptr;
+    std::unique_ptr<GpuTimer> gpuTimer;
+    int frame = 0;                      // this view's iFrame counter
+
+    // Event thread -> render thread
+    std::atomic<double> mouseX{ 0.0 }, mouseY{ 0.0 };
+    std::atomic<bool> mouseDown{ false };
+    std::atomic<int> fbWidth{ 0 }, fbHeight{ 0 };
+
+    // Render thread only
+    int seenWidth = 0, seenHeight = 0;
+    double sizeChangedAt = 0.0;
+    int frames = 0;
+    double cpuMs = 0.0, gpuMs = 0.0;
+    int gpuSamples = 0;
+
+    std::string pendingTitle;           // guarded by g_titleMutex
+};
+
+void viewCursorPosCallback(GLFWwindow* window, double x, double y) {
+    View* view = static_cast<View*>(glfwGetWindowUserPointer(window));
+    view->mouseX.store(x, std::memory_order_relaxed);
+    view->mouseY.store(y, std::memory_order_relaxed);
+}
+
+void viewMouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    View* view = static_cast<View*>(glfwGetWindowUserPointer(window));
+    if (button == GLFW_MOUSE_BUTTON_LEFT) view->mouseDown.store(action == GLFW_PRESS, std::memory_order_relaxed);
+}
+
+void viewFramebufferSizeCallback(GLFWwindow* window, int w, int h) {
+    View* view = static_cast<View*>(glfwGetWindowUserPointer(window));
+    view->fbWidth.store(w, std::memory_order_relaxed);
+    view->fbHeight.store(h, std::memory_order_relaxed);
+}
+
+// Runs until any view window is closed. mainPipeline is already built and allocated in
+// the main window's context, which must be current on entry; it becomes view 0.
+int RunMultiView(GLFWwindow* mainWindow, Pipeline&& mainPipeline,
+    const std::vector<std::vector<std::string>>& viewFiles,
+    const std::vector<std::vector<std::array<ChannelInput, 4>>>& viewChannels,
+    const AppOptions& options, ProgramCache& programCache, const VertexBuffer& quadVbo,
+    const VertexArray& mainVao, const Texture& emptyTex, const std::vector<fs::path>& images, bool srgbOutput) {
+    if (!options.recordPath.empty() || !options.replayPath.empty() || !options.exportPath.empty() ||
+        !options.controlSocket.empty()) {
+        std::cerr << "--record, --replay, --export and --control apply to a single view; ignored with --view\n";
+    }
+    if (options.pacing == PacingMode::LOW_LATENCY) {
+        std::cerr << "--pacing=low-latency applies to a single view; with --view only --fps-cap paces frames\n";
+    }
+
+    std::vector<std::unique_ptr<View>> views;
+    auto addView = [&](const std::string& name, GLFWwindow* window, int w, int h) -> View& {
+        views.push_back(std::make_unique<View>());
+        View& v = *views.back();
+        v.name = name;
+        v.window = window;
+        v.context = window ? window : mainWindow;
+        v.vao = &mainVao;
+        v.pool.roundToBucket = options.bucketedTargets;
+        v.fbWidth = v.seenWidth = w;
+        v.fbHeight = v.seenHeight = h;
+        if (window) {
+            glfwSetWindowUserPointer(window, &v);
+            glfwSetCursorPosCallback(window, viewCursorPosCallback);
+            glfwSetMouseButtonCallback(window, viewMouseButtonCallback);
+            glfwSetFramebufferSizeCallback(window, viewFramebufferSizeCallback);
+        }
+        return v;
+    };
+
+    View& mainView = addView("frag", mainWindow, mainPipeline.width, mainPipeline.height);
+    mainView.pipeline = std::move(mainPipeline);
+
+    bool ok = true;
+    for (size_t i = 0; i < options.views.size() && ok; ++i) {
+        const ViewSpec& spec = options.views[i];
+        int w = spec.width > 0 ? spec.width : mainView.pipeline.width;
+        int h = spec.height > 0 ? spec.height : mainView.pipeline.height;
+        GLFWwindow* window = nullptr;
+        if (!spec.headless) {
+            std::string title = "Evolve Shader - " + spec.dir;
+            window = glfwCreateWindow(w, h, title.c_str(), nullptr, mainWindow);
+            if (!window) {
+                std::cerr << "Failed to create window for view " << spec.dir << "\n";
+                ok = false;
+                break;
+            }
+            glfwGetFramebufferSize(window, &w, &h);
+        }
+        View& v = addView(spec.dir, window, w, h);
+
+        std::vector<std::string> passNames, passSources;
+        if (!BuildPipeline(v.pipeline, viewFiles[i], viewChannels[i], options, programCache, passNames, passSources)) {
+            std::cerr << "View " << spec.dir << " has no usable passes\n";
+            ok = false;
+        }
+        for (const auto& chs : viewChannels[i]) {
+            for (const auto& input : chs) {
+                if (input.type == ChannelInput::IMAGE_GLOBAL &&
+                    input.imageIndex >= 0 && input.imageIndex < (int)images.size()) {
+                    g_textureCache.prefetch(images[input.imageIndex].string());
+                }
+            }
+        }
+    }
+    std::vector<Pipeline*> pipelines;
+    for (auto& v : views) pipelines.push_back(&v->pipeline);
+    MarkSharedPrograms(pipelines);
+
+    if (ok) {
+        size_t passes = 0;
+        for (const auto& v : views) {
+            for (const auto& variants : v->pipeline.variants) passes += variants.size();
+        }
+        std::cout << "[Views] " << views.size() << " view(s), " << programCache.size() << " program(s) for "
+                  << passes << " pass variant(s); " << g_textureCache.statsString() << "\n";
+
+        glfwMakeContextCurrent(nullptr);
+        std::atomic<bool> setupFailed{ false };
+        std::thread renderThread([&] {
+            GLFWwindow* current = nullptr;
+            auto makeCurrent = [&](GLFWwindow* context) {
+                if (context != current) glfwMakeContextCurrent(context);
+                current = context;
+            };
+            // With vsync on every window one round would wait for one vblank per window;
+            // only the last window waits
+            GLFWwindow* vsyncWindow = nullptr;
+            if (options.pacing == PacingMode::VSYNC) {
+                for (auto& v : views) if (v->window) vsyncWindow = v->window;
+            }
+
+            for (auto& v : views) {
+                makeCurrent(v->context);
+                if (v->window) glfwSwapInterval(v->window == vsyncWindow ? 1 : 0);
+                // Per-context state; secondary windows are created sRGB-capable like the main one
+                if (v->window && srgbOutput) glEnable(GL_FRAMEBUFFER_SRGB);
+                if (v->window && v->window != mainWindow) {
+                    v->ownVao = std::make_unique<VertexArray>();
+                    SetupQuadVertexArray(*v->ownVao, quadVbo);
+                    v->vao = v->ownVao.get();
+                }
+                v->gpuTimer = std::make_unique<GpuTimer>();
+                // Without its targets a view's passes would draw into the window itself
+                if (v->pipeline.fbos.empty() &&
+                    !AllocatePipelineTargets(v->pipeline, v->pool, v->seenWidth, v->seenHeight)) {
+                    std::cerr << "View " << v->name << ": failed to allocate render targets\n";
+                    setupFailed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (setupFailed.load(std::memory_order_relaxed)) {
+                g_quit.store(true, std::memory_order_release);
+                glfwPostEmptyEvent();
+            }
+
+            g_start = std::chrono::steady_clock::now();
+            float lastTimeVal = 0.0f;
+            double lastStatsTime = glfwGetTime();
+            double nextRound = lastStatsTime;
+            long long round = 0;
+
+            while (!g_quit.load(std::memory_order_acquire)) {
+                if (options.fpsCap > 0.0) {
+                    nextRound += 1.0 / options.fpsCap;
+                    PreciseSleepUntil(nextRound);
+                    if (glfwGetTime() - nextRound > 0.1) nextRound = glfwGetTime();  // fell behind: don't burst
+                }
+                g_textureCache.beginFrame();
+                float t = std::chrono::duration<float>(std::chrono::steady_clock::now() - g_start).count();
+                float dt = t - lastTimeVal;
+                lastTimeVal = t;
+
+                for (auto& vp : views) {
+                    View& v = *vp;
+                    Pipeline& p = v.pipeline;
+                    makeCurrent(v.context);
+                    double cpuStart = glfwGetTime();
+
+                    // Debounced resize, as in single-view mode
+                    int fw = v.fbWidth.load(std::memory_order_relaxed);
+                    int fh = v.fbHeight.load(std::memory_order_relaxed);
+                    if (fw != v.seenWidth || fh != v.seenHeight) {
+                        v.seenWidth = fw;
+                        v.seenHeight = fh;
+                        v.sizeChangedAt = cpuStart;
+                    }
+                    if (fw > 0 && fh > 0 && (fw != p.width || fh != p.height) &&
+                        cpuStart - v.sizeChangedAt >= options.resizeDebounceSec) {
+                        // On failure, retry only once the window changes size again
+                        if (!ApplyResize(p, v.pool, fw, fh)) v.sizeChangedAt = std::numeric_limits<double>::infinity();
+                    }
+
+                    FrameParams params;
+                    params.time = t;
+                    params.timeDelta = dt;
+                    params.mouseX = (float)v.mouseX.load(std::memory_order_relaxed);
+                    params.mouseY = (float)(p.height - v.mouseY.load(std::memory_order_relaxed));
+                    params.mouseDown = v.mouseDown.load(std::memory_order_relaxed) ? 1.0f : 0.0f;
+
+                    auto onGpuTime = [&v](long long, double ms) { v.gpuMs += ms; ++v.gpuSamples; };
+                    g_frame = v.frame;
+                    v.gpuTimer->begin(round, onGpuTime);
+                    RenderPipelineFrame(p, params, *v.vao, emptyTex, images, v.window != nullptr, fw, fh);
+                    v.gpuTimer->end();
+                    v.gpuTimer->collect(onGpuTime);
+                    v.frame = g_frame;
+                    if (v.window) glfwSwapBuffers(v.window);
+
+                    v.cpuMs += (glfwGetTime() - cpuStart) * 1000.0;
+                    ++v.frames;
+                }
+                ++round;
+
+                double now = glfwGetTime();
+                if (now - lastStatsTime >= 1.0) {
+                    double elapsed = now - lastStatsTime;
+                    std::string line = "[Views]";
+                    {
+                        std::lock_guard<std::mutex> lock(g_titleMutex);
+                        for (auto& vp : views) {
+                            View& v = *vp;
+                            char buf[160];
+                            snprintf(buf, sizeof(buf), "%s: %.0f fps, CPU %.2f ms, GPU %.2f ms", v.name.c_str(),
+                                v.frames / elapsed, v.frames ? v.cpuMs / v.frames : 0.0,
+                                v.gpuSamples ? v.gpuMs / v.gpuSamples : 0.0);
+                            line += std::string(" | ") + buf;
+                            if (v.window) v.pendingTitle = std::string("Evolve Shader - ") + buf;
+                            v.frames = v.gpuSamples = 0;
+                            v.cpuMs = v.gpuMs = 0.0;
+                        }
+                    }
+                    std::cout << line << "\n";
+                    glfwPostEmptyEvent();
+                    lastStatsTime = now;
+                }
+            }
+
+            // Per-view objects are released in the context that owns them
+            for (auto& v : views) {
+                makeCurrent(v->context);
+                v->gpuTimer.reset();
+                v->pipeline = Pipeline();
+                v->pool.clear();
+                v->ownVao.reset();
+            }
+            std::cout << "[TextureCache] " << g_textureCache.statsString() << "\n";
+            g_textureCache.clear();
+            makeCurrent(nullptr);
+        });
+
+        auto anyClosed = [&] {
+            for (const auto& v : views) {
+                if (v->window && glfwWindowShouldClose(v->window)) return true;
+            }
+            return false;
+        };
+        while (!anyClosed() && !g_quit.load(std::memory_order_acquire)) {
+            glfwWaitEventsTimeout(0.1);
+            std::lock_guard<std::mutex> lock(g_titleMutex);
+            for (auto& v : views) {
+                if (v->window && !v->pendingTitle.empty()) {
+                    glfwSetWindowTitle(v->window, v->pendingTitle.c_str());
+                    v->pendingTitle.clear();
+                }
+            }
+        }
+        g_quit.store(true, std::memory_order_release);
+        renderThread.join();
+        glfwMakeContextCurrent(mainWindow);
+        if (setupFailed.load(std::memory_order_relaxed)) ok = false;
+    }
+
+    // Views that never reached the render thread still hold objects of the main context
+    for (auto& v : views) {
+        v->pipeline = Pipeline();
+        v->pool.clear();
+        if (v->window && v->window != mainWindow) glfwDestroyWindow(v->window);
+    }
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    AppOptions options = ParseCommandLine(argc, argv);
+
     auto g_globalImages = ScanGlobalImages();
     if (!g_globalImages.empty()) {
         std::cout << "\nFound " << g_globalImages.size() << " global image(s):\n";
@@ -547,11 +3283,31 @@ int main() {
 
     auto channelConfig = ConfigureChannelsInteractively(fragFiles, g_globalImages);
 
+    std::vector<std::vector<std::string>> viewFiles;
+    std::vector<std::vector<std::array<ChannelInput, 4>>> viewChannels;
+    for (const auto& spec : options.views) {
+        if (!fs::is_directory(spec.dir)) {
+            std::cerr << "Error: view folder '" << spec.dir << "' not found!\n";
+            return -1;
+        }
+        viewFiles.push_back(ScanShaderFiles(spec.dir));
+        if (viewFiles.back().empty()) {
+            std::cerr << "No .frag files found in '" << spec.dir << "'!\n";
+            return -1;
+        }
+        std::cout << "\nView '" << spec.dir << "': " << viewFiles.back().size() << " shader(s)\n";
+        for (size_t i = 0; i < viewFiles.back().size(); ++i) {
+            std::cout << "  [" << i << "] " << fs::path(viewFiles.back()[i]).filename().string() << "\n";
+        }
+        viewChannels.push_back(ConfigureChannelsInteractively(viewFiles.back(), g_globalImages));
+    }
+
     if (!glfwInit()) return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
+    if (options.analyzeFrames > 0 || options.headless) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     GLFWwindow* window = glfwCreateWindow(g_winWidth, g_winHeight, "Evolve Shader", nullptr, nullptr);
     if (!window) { glfwTerminate(); return -1; }
@@ -559,7 +3315,9 @@ int main() {
     glfwSetCursorPosCallback(window, cursorPosCallback);
     glfwSetMouseButtonCallback(window, mouseButtonCallback);
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
-    glfwSwapInterval(0);
+    glfwGetFramebufferSize(window, &g_winWidth, &g_winHeight);
+    g_pendingWidth = g_winWidth;
+    g_pendingHeight = g_winHeight;
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         glfwDestroyWindow(window);
@@ -568,7 +3326,8 @@ int main() {
     }
 
     std::cout << "OpenGL: " << glGetString(GL_VERSION) << "\n";
-    if (glfwGetWindowAttrib(window, GLFW_SRGB_CAPABLE)) glEnable(GL_FRAMEBUFFER_SRGB);
+    bool srgbOutput = glfwGetWindowAttrib(window, GLFW_SRGB_CAPABLE) != 0;
+    if (srgbOutput) glEnable(GL_FRAMEBUFFER_SRGB);
 
     VertexArray vao;
     float quad[] = {
@@ -580,150 +3339,288 @@ int main() {
         -1.f,  1.f, 0.f, 1.f
     };
     VertexBuffer vbo(quad, sizeof(quad));
-    vao.bind(); vbo.bind();
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    VertexArray::unbind();
-
-    std::vector<GLProgram> programs;
-    for (const auto& file : fragFiles) {
-        std::string code = LoadShaderFile(file);
-        if (code.empty()) continue;
-        code = WrapShadertoyShader(code);
-        programs.emplace_back(vertShaderSrc, code.c_str());
-    }
-    if (programs.empty()) return -1;
+    SetupQuadVertexArray(vao, vbo);
 
-    std::vector<Framebuffer> fbos(programs.size());
-    for (auto& fbo : fbos) {
-        if (!fbo.create(g_winWidth, g_winHeight)) return -1;
-    }
-    glfwSetWindowUserPointer(window, &fbos);
+    ProgramCache programCache;
+    Pipeline pipeline;
+    std::vector<std::string> passNames;
+    std::vector<std::string> passSources;
+    if (!BuildPipeline(pipeline, fragFiles, channelConfig, options, programCache, passNames, passSources)) return -1;
+    MarkSharedPrograms({ &pipeline });
 
-    // Store previous frame's output for feedback (stable texture IDs)
-    std::vector<Texture> prevFrameTextures(programs.size());
-    for (auto& tex : prevFrameTextures) {
-        glGenTextures(1, &tex.id);
-        glBindTexture(GL_TEXTURE_2D, tex.id);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, g_winWidth, g_winHeight, 0, GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        tex.width = g_winWidth;
-        tex.height = g_winHeight;
-    }
+    RenderTargetPool targetPool;
+    targetPool.roundToBucket = options.bucketedTargets;
+    if (!AllocatePipelineTargets(pipeline, targetPool, g_winWidth, g_winHeight)) return -1;
 
     Texture emptyTex;
     emptyTex.createEmpty();
 
-    g_start = std::chrono::steady_clock::now();
-    float lastTimeVal = 0.0f;
-    double lastFPSTime = glfwGetTime();
-    int frameCount = 0;
+    // Before the advisor, which loads images too
+    g_textureCache.budgetBytes = options.textureBudgetMB * 1024u * 1024u;
+    g_textureCache.diskBudgetBytes = options.textureDiskCacheMB * 1024u * 1024u;
 
-    while (!glfwWindowShouldClose(window)) {
-        double currentTime = glfwGetTime();
-        frameCount++;
-        if (currentTime - lastFPSTime >= 1.0) {
-            std::string title = "Evolve Shader - FPS: " + std::to_string(frameCount);
-            glfwSetWindowTitle(window, title.c_str());
-            frameCount = 0;
-            lastFPSTime = currentTime;
-        }
-
-        auto now = std::chrono::steady_clock::now();
-        float t = std::chrono::duration<float>(now - g_start).count();
-        float dt = t - lastTimeVal;
-        lastTimeVal = t;
-
-        int width = g_winWidth;
-        int height = g_winHeight;
+    if (options.analyzeFrames > 0) {
+        RunFormatAdvisor(pipeline, targetPool, vao, emptyTex, g_globalImages, passNames, options);
+        g_textureCache.clear();
+        return 0;
+    }
 
-        // Resize prevFrameTextures if needed
-        for (auto& tex : prevFrameTextures) {
-            if (tex.width != width || tex.height != height) {
-                glBindTexture(GL_TEXTURE_2D, tex.id);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
-                tex.width = width;
-                tex.height = height;
+    // Only images the pipeline actually references are ever loaded; do it up front
+    // so the first frames don't stall on decoding
+    for (const auto& chs : channelConfig) {
+        for (const auto& input : chs) {
+            if (input.type == ChannelInput::IMAGE_GLOBAL &&
+                input.imageIndex >= 0 && input.imageIndex < (int)g_globalImages.size()) {
+                g_textureCache.prefetch(g_globalImages[input.imageIndex].string());
             }
         }
+    }
+    if (g_textureCache.size() > 0) std::cout << "[TextureCache] " << g_textureCache.statsString() << "\n";
 
-        // Render each pass
-        for (size_t i = 0; i < programs.size(); ++i) {
-            programs[i].use();
-            glUniform3f(programs[i].getUniformLocation("iResolution"), (float)width, (float)height, 1.0f);
-            glUniform1f(programs[i].getUniformLocation("iTime"), t);
-            glUniform1f(programs[i].getUniformLocation("iTimeDelta"), dt);
-            glUniform1i(programs[i].getUniformLocation("iFrame"), g_frame++);
-            glUniform4f(programs[i].getUniformLocation("iMouse"),
-                (float)g_mouseX, (float)(height - g_mouseY), (float)g_mouseDown, 0.0f);
+    if (!options.views.empty()) {
+        return RunMultiView(window, std::move(pipeline), viewFiles, viewChannels, options, programCache,
+            vbo, vao, emptyTex, g_globalImages, srgbOutput);
+    }
 
-            auto& configForThis = channelConfig[i];
+    std::vector<ControlServer::ParamInfo> paramCatalog;
+    for (size_t i = 0; i < pipeline.params.size(); ++i) {
+        for (size_t j = 0; j < pipeline.params[i].size(); ++j) {
+            paramCatalog.push_back({ (int)i, (int)j, pipeline.params[i][j] });
+        }
+    }
+    ControlServer controlServer(options.controlSocket, paramCatalog);
+    if (!options.controlSocket.empty()) controlServer.start();
+
+    // Hand the context to the render thread; from here on this thread only pumps events
+    glfwMakeContextCurrent(nullptr);
+
+    std::thread renderThread([&] {
+        glfwMakeContextCurrent(window);
+        // Release the context after everything below that owns GL objects is destroyed
+        struct ContextRelease { ~ContextRelease() { glfwMakeContextCurrent(nullptr); } } contextRelease;
+        FramePacer pacer(options.pacing, options.fpsCap, options.maxFramesInFlight);
+        glfwSwapInterval(pacer.swapInterval());
+
+        InputSnapshot frameInput;
+        frameInput.fbWidth = g_winWidth;
+        frameInput.fbHeight = g_winHeight;
+        bool resizePending = false;
+        double lastResizeEvent = 0.0;
+        int failedReplayWidth = 0, failedReplayHeight = 0;  // last recorded size that couldn't be allocated
+
+        g_start = std::chrono::steady_clock::now();
+        float lastTimeVal = 0.0f;
+        double lastFPSTime = glfwGetTime();
+        int frameCount = 0;
+        size_t loggedCacheLoads = g_textureCache.misses + g_textureCache.evictions;
+
+        FrameRecorder recorder;
+        if (!options.recordPath.empty() && recorder.open(options.recordPath)) {
+            std::cout << "Recording frames to " << options.recordPath << "\n";
+        }
+        FrameReplay replay;
+        // On failure skip the loop but still run the teardown below
+        bool replayFailed = !options.replayPath.empty() && !replay.load(options.replayPath);
+        if (replayFailed) {
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+            glfwPostEmptyEvent();
+        }
+        GpuTimer gpuTimer;
+        ReplayProfile profile;
+        // Automatic tier selection stays off during a replay: tiers come from the recording
+        bool autoQuality = pipeline.tierCount() > 1 && options.qualityTier < 0 && !replay.isLoaded();
+        QualityController quality(pipeline.tierCount(), pipeline.tier, options.gpuBudgetMs);
+        bool timeFrames = replay.isLoaded() || autoQuality;
+        long long timedFrame = 0;
+        double lastGpuMs = -1.0;
+        auto onGpuTime = [&](long long frame, double ms) {
+            lastGpuMs = ms;
+            if (replay.isLoaded()) profile.frameMs.emplace_back(frame, ms);
+            if (autoQuality) quality.addSample(frame, ms, timedFrame);
+        };
+        double replayStart = glfwGetTime();
+        long long renderedFrames = 0;
+
+        while (!replayFailed && !g_quit.load(std::memory_order_acquire)) {
+            // Wait for the pacer first, then pick up input as late as possible before rendering.
+            // Snapshots are complete states, so the newest one is the input for this frame.
+            pacer.waitForFrameSlot();
+            double inputTime = -1.0;
+            InputSnapshot snap;
+            while (g_inputQueue.pop(snap)) {
+                if (snap.fbWidth != frameInput.fbWidth || snap.fbHeight != frameInput.fbHeight) {
+                    resizePending = true;
+                    lastResizeEvent = snap.time;
+                }
+                if (snap.source == InputSnapshot::MOUSE) inputTime = snap.time;
+                frameInput = snap;
+            }
 
-            for (int c = 0; c < 4; ++c) {
-                const ChannelInput& input = configForThis[c];
-                std::string name = "iChannel" + std::to_string(c);
-                GLint loc = programs[i].getUniformLocation(name);
-                if (loc == -1) continue;
+            double currentTime = glfwGetTime();
+            frameCount++;
+            if (currentTime - lastFPSTime >= 1.0) {
+                std::string title = "Evolve Shader - FPS: " + std::to_string(frameCount);
+                double latAvg, latMax;
+                if (pacer.takeLatencyStats(latAvg, latMax)) {
+                    char buf[64];
+                    snprintf(buf, sizeof(buf), " | Latency: %.1f ms (max %.1f)", latAvg, latMax);
+                    title += buf;
+                }
+                if (pipeline.tierCount() > 1) {
+                    char buf[64];
+                    snprintf(buf, sizeof(buf), " | Tier: %d/%d (%s)", pipeline.tier, pipeline.tierCount() - 1,
+                        autoQuality ? "auto" : "pinned");
+                    title += buf;
+                }
+                if (timeFrames && lastGpuMs >= 0.0) {
+                    char buf[64];
+                    snprintf(buf, sizeof(buf), " | GPU: %.1f ms", autoQuality ? quality.smoothedMs() : lastGpuMs);
+                    title += buf;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(g_titleMutex);
+                    g_pendingTitle = title;
+                }
+                glfwPostEmptyEvent();
+                frameCount = 0;
+                lastFPSTime = currentTime;
+
+                size_t cacheLoads = g_textureCache.misses + g_textureCache.evictions;
+                if (cacheLoads != loggedCacheLoads) {
+                    std::cout << "[TextureCache] " << g_textureCache.statsString() << "\n";
+                    loggedCacheLoads = cacheLoads;
+                }
+            }
+            g_textureCache.beginFrame();
+
+            auto now = std::chrono::steady_clock::now();
+            float t = std::chrono::duration<float>(now - g_start).count();
+            float dt = t - lastTimeVal;
+            lastTimeVal = t;
+
+            // Apply a pending resize once the window has stopped changing size.
+            // During a replay the render size comes from the recording instead.
+            if (resizePending && !replay.isLoaded() && currentTime - lastResizeEvent >= options.resizeDebounceSec) {
+                resizePending = false;
+                if (frameInput.fbWidth > 0 && frameInput.fbHeight > 0 &&
+                    (frameInput.fbWidth != pipeline.width || frameInput.fbHeight != pipeline.height)) {
+                    ApplyResize(pipeline, targetPool, frameInput.fbWidth, frameInput.fbHeight);
+                    g_winWidth = pipeline.width;
+                    g_winHeight = pipeline.height;
+                }
+            }
 
-                Texture* texToBind = &emptyTex;
+            ApplyParamUpdates(pipeline);
+            if (autoQuality && quality.tier() != pipeline.tier) {
+                std::cout << "[Quality] tier " << pipeline.tier << " -> " << quality.tier()
+                          << " (GPU " << quality.smoothedMs() << " ms, budget " << options.gpuBudgetMs << " ms)\n";
+                pipeline.setTier(quality.tier());
+            }
 
-                switch (input.type) {
-                case ChannelInput::NONE:
-                    break;
-                case ChannelInput::IMAGE_GLOBAL:
-                    if (input.imageIndex >= 0 && input.imageIndex < (int)g_globalImages.size()) {
-                        std::string imgPath = g_globalImages[input.imageIndex].string();
-                        texToBind = GetTextureForPath(imgPath);
+            FrameRecord record;
+            if (replay.isLoaded()) {
+                // Replay: time, frame counter, mouse and render size come from the file
+                if (!replay.next(record)) {
+                    gpuTimer.collect(onGpuTime, true);
+                    profile.wallSeconds = glfwGetTime() - replayStart;
+                    if (pipeline.tierCount() > 1) {
+                        std::cout << "[Replay] quality tier "
+                                  << (options.qualityTier >= 0 ? "pinned to " + std::to_string(pipeline.tier) : "as recorded") << "\n";
                     }
-                    break;
-                case ChannelInput::BUFFER:
-                    texToBind = &prevFrameTextures[input.bufferIndex]; // Always read from previous frame
+                    profile.report(options.replayTimingsPath);
+                    glfwSetWindowShouldClose(window, GLFW_TRUE);
+                    glfwPostEmptyEvent();
                     break;
                 }
-
-                texToBind->bind(c);
-                glUniform1i(loc, c);
-
-                std::string resName = "iChannelResolution[" + std::to_string(c) + "]";
-                GLint resLoc = programs[i].getUniformLocation(resName);
-                if (resLoc != -1) {
-                    glUniform3f(resLoc, (float)texToBind->width, (float)texToBind->height, 1.0f);
+                if ((record.width != pipeline.width || record.height != pipeline.height) &&
+                    (record.width != failedReplayWidth || record.height != failedReplayHeight) &&
+                    !ApplyResize(pipeline, targetPool, record.width, record.height)) {
+                    failedReplayWidth = record.width;  // keep rendering at the current size
+                    failedReplayHeight = record.height;
                 }
-            }
-
-            // Set render target
-            if (i == programs.size() - 1) {
-                Framebuffer::unbind();
-                glViewport(0, 0, width, height);
+                // Render each frame at the tier it was recorded with, unless --quality-tier pins one
+                if (options.qualityTier < 0 && record.qualityTier >= 0 && record.qualityTier != pipeline.tier) {
+                    pipeline.setTier(record.qualityTier);
+                }
+                g_frame = record.frame;
             }
             else {
-                fbos[i].bind();
-                glViewport(0, 0, width, height);
+                record.time = t;
+                record.timeDelta = dt;
+                record.frame = g_frame;
+                record.mouseX = (float)frameInput.mouseX;
+                record.mouseY = (float)(pipeline.height - frameInput.mouseY);
+                record.mouseDown = frameInput.mouseDown;
+                record.width = pipeline.width;
+                record.height = pipeline.height;
+                record.qualityTier = pipeline.tier;
+            }
+            if (recorder.isOpen()) recorder.write(record);
+
+            FrameParams params;
+            params.time = record.time;
+            params.timeDelta = record.timeDelta;
+            params.mouseX = record.mouseX;
+            params.mouseY = record.mouseY;
+            params.mouseDown = (float)record.mouseDown;
+
+            // timedFrame is the tag of the frame being submitted, so results collected in
+            // begin() report it as the next frame to render; after end() it moves on
+            if (timeFrames) gpuTimer.begin(timedFrame, onGpuTime);
+            RenderPipelineFrame(pipeline, params, vao, emptyTex, g_globalImages,
+                !options.headless, frameInput.fbWidth, frameInput.fbHeight);
+            if (timeFrames) {
+                gpuTimer.end();
+                ++timedFrame;
+                gpuTimer.collect(onGpuTime);
             }
 
-            glClearColor(0, 0, 0, 1);
-            glClear(GL_COLOR_BUFFER_BIT);
-            vao.bind();
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            VertexArray::unbind();
-        }
+            if (!options.headless) glfwSwapBuffers(window);
+            pacer.frameSubmitted(inputTime);
 
-        // === Copy current FBO outputs to prevFrameTextures using glCopyTexSubImage2D ===
-        for (size_t i = 0; i < fbos.size(); ++i) {
-            glBindTexture(GL_TEXTURE_2D, prevFrameTextures[i].id);
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[i].fbo);
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            // Poster exports run between frames with this frame's time and input
+            std::string exportPath;
+            {
+                std::lock_guard<std::mutex> lock(g_exportMutex);
+                exportPath.swap(g_exportRequest);
+            }
+            std::error_code existsError;
+            if (!exportPath.empty() && (fs::exists(exportPath, existsError) || existsError)) {
+                std::cerr << "Export skipped, not overwriting " << exportPath << "\n";
+                exportPath.clear();
+            }
+            bool exportAndQuit = !options.exportPath.empty() && ++renderedFrames == options.exportFrame;
+            if (exportAndQuit) exportPath = options.exportPath;
+            if (!exportPath.empty()) {
+                ExportPoster(pipeline, exportPath, options, params, vao, emptyTex, g_globalImages, srgbOutput);
+            }
+            if (exportAndQuit) {
+                glfwSetWindowShouldClose(window, GLFW_TRUE);
+                glfwPostEmptyEvent();
+                break;
+            }
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        if (recorder.isOpen()) std::cout << "Recorded " << recorder.frames << " frame(s)\n";
+
+        std::cout << "[TextureCache] " << g_textureCache.statsString() << "\n";
+        g_textureCache.clear();
+    });
+
+    while (!glfwWindowShouldClose(window)) {
+        glfwWaitEventsTimeout(0.1);
+        RetryDroppedSnapshot();
+        std::lock_guard<std::mutex> lock(g_titleMutex);
+        if (!g_pendingTitle.empty()) {
+            glfwSetWindowTitle(window, g_pendingTitle.c_str());
+            g_pendingTitle.clear();
+        }
     }
 
+    g_quit.store(true, std::memory_order_release);
+    renderThread.join();
+    // GL objects owned by main() are released on this thread
+    glfwMakeContextCurrent(window);
+
     return 0;
 }
\ No newline at end of file